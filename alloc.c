@@ -0,0 +1,177 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "alloc.h"
+
+#ifdef ALLOC_STATS
+
+#undef alloc_malloc
+#undef alloc_calloc
+#undef alloc_realloc
+#undef alloc_free
+
+/* Header before every block; the union keeps the block aligned for any type */
+typedef union {
+  struct {
+    size_t size;
+    AllocTag tag;
+  } h;
+  max_align_t align;
+} AllocHeader;
+
+typedef enum { ALLOC_EVENT_ALLOC, ALLOC_EVENT_FREE, ALLOC_EVENT_REALLOC } AllocEvent;
+
+static const char *alloc_names[ALLOC_TAGS + 1] = {"stack", "queue", "list", "tree", "music",
+                                                  "total"};
+
+/* The last entry is the sum of all the tags */
+static AllocStats alloc_stats[ALLOC_TAGS + 1];
+static pthread_mutex_t alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t alloc_once = PTHREAD_ONCE_INIT;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static void alloc_dump(void);
+static void alloc_register(void);
+static void alloc_add(AllocStats *s, size_t old_size, size_t new_size);
+static void alloc_count(AllocTag tag, AllocEvent event, size_t old_size, size_t new_size);
+
+static void alloc_dump(void) {
+  alloc_print(stderr);
+}
+
+static void alloc_register(void) {
+  atexit(alloc_dump);
+}
+
+static void alloc_add(AllocStats *s, size_t old_size, size_t new_size) {
+  s->bytes = s->bytes - old_size + new_size;
+  if (s->bytes > s->peak_bytes) s->peak_bytes = s->bytes;
+  s->total_bytes += new_size;
+}
+
+static void alloc_count(AllocTag tag, AllocEvent event, size_t old_size, size_t new_size) {
+  int i;
+
+  pthread_once(&alloc_once, alloc_register);
+
+  pthread_mutex_lock(&alloc_mutex);
+  for (i = 0; i < 2; i++) {
+    AllocStats *s = &alloc_stats[(i == 0) ? tag : ALLOC_TAGS];
+
+    if (event == ALLOC_EVENT_ALLOC) {
+      s->allocs++;
+    } else if (event == ALLOC_EVENT_FREE) {
+      s->frees++;
+    } else {
+      s->reallocs++;
+    }
+    alloc_add(s, old_size, new_size);
+  }
+  pthread_mutex_unlock(&alloc_mutex);
+}
+
+/*----------------------------------------------------------------------------------------*/
+void *alloc_malloc(AllocTag tag, size_t size) {
+  AllocHeader *h;
+
+  if (tag < 0 || tag >= ALLOC_TAGS) return NULL;
+
+  h = (AllocHeader *)malloc(sizeof(AllocHeader) + size);
+  if (!h) return NULL;
+
+  h->h.size = size;
+  h->h.tag = tag;
+  alloc_count(tag, ALLOC_EVENT_ALLOC, 0, size);
+
+  return h + 1;
+}
+
+void *alloc_calloc(AllocTag tag, size_t n, size_t size) {
+  void *p;
+
+  if (size > 0 && n > ((size_t)-1 - sizeof(AllocHeader)) / size) return NULL;
+
+  p = alloc_malloc(tag, n * size);
+  if (p) memset(p, 0, n * size);
+
+  return p;
+}
+
+void *alloc_realloc(AllocTag tag, void *p, size_t size) {
+  AllocHeader *h;
+  size_t old_size;
+
+  if (!p) return alloc_malloc(tag, size);
+
+  h = (AllocHeader *)p - 1;
+  old_size = h->h.size;
+  h = (AllocHeader *)realloc(h, sizeof(AllocHeader) + size);
+  if (!h) return NULL;
+
+  /* A block keeps the tag it was created with */
+  h->h.size = size;
+  alloc_count(h->h.tag, ALLOC_EVENT_REALLOC, old_size, size);
+
+  return h + 1;
+}
+
+void alloc_free(void *p) {
+  AllocHeader *h;
+
+  if (!p) return;
+
+  h = (AllocHeader *)p - 1;
+  alloc_count(h->h.tag, ALLOC_EVENT_FREE, h->h.size, 0);
+  free(h);
+}
+
+Status alloc_getStats(AllocTag tag, AllocStats *stats) {
+  if (!stats || tag < 0 || tag > ALLOC_TAGS) return ERROR;
+
+  pthread_mutex_lock(&alloc_mutex);
+  *stats = alloc_stats[tag];
+  pthread_mutex_unlock(&alloc_mutex);
+
+  return OK;
+}
+
+int alloc_print(FILE *pf) {
+  AllocStats s;
+  int i, n, total;
+
+  if (!pf) return -1;
+
+  total = fprintf(pf, "%-6s %10s %10s %10s %12s %12s %14s\n", "alloc", "allocs", "frees",
+                  "reallocs", "live_bytes", "peak_bytes", "total_bytes");
+  if (total < 0) return -1;
+
+  for (i = 0; i <= ALLOC_TAGS; i++) {
+    alloc_getStats((AllocTag)i, &s);
+    n = fprintf(pf, "%-6s %10ld %10ld %10ld %12zu %12zu %14zu\n", alloc_names[i], s.allocs,
+                s.frees, s.reallocs, s.bytes, s.peak_bytes, s.total_bytes);
+    if (n < 0) return -1;
+    total += n;
+  }
+
+  return total;
+}
+
+#else
+
+Status alloc_getStats(AllocTag tag, AllocStats *stats) {
+  (void)tag;
+  (void)stats;
+
+  return ERROR;
+}
+
+int alloc_print(FILE *pf) {
+  (void)pf;
+
+  return -1;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file alloc.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Optional accounting of the memory allocated by the ADTs
+ *
+ * @details The ADTs allocate through alloc_malloc, alloc_calloc,
+ * alloc_realloc and alloc_free, giving a tag with the kind of structure.
+ * In a normal build these are plain malloc, calloc, realloc and free.
+ * When built with ALLOC_STATS defined (make ALLOC_STATS=1, after make
+ * clean) every block carries a small header with its size and tag, and
+ * the number of allocations, live bytes and peak bytes of every tag are
+ * counted. The counters are printed to stderr when the program exits.
+ *
+ * Memory obtained from these functions must be released with alloc_free,
+ * and memory from plain malloc with plain free.
+ */
+
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "types.h"
+
+/**
+ * @brief Kinds of structure whose allocations are counted.
+ */
+typedef enum {
+  ALLOC_STACK,  /*!< Stack and its array */
+  ALLOC_QUEUE,  /*!< Queue (the list version counts its nodes as ALLOC_LIST) */
+  ALLOC_LIST,   /*!< List and its nodes */
+  ALLOC_TREE,   /*!< BSTree and its nodes */
+  ALLOC_MUSIC,  /*!< Music and its parsing buffers */
+  ALLOC_TAGS    /*!< Number of tags */
+} AllocTag;
+
+/**
+ * @brief Counters of one tag.
+ */
+typedef struct {
+  long allocs;         /*!< Blocks allocated */
+  long frees;          /*!< Blocks freed */
+  long reallocs;       /*!< Blocks resized */
+  size_t bytes;        /*!< Bytes currently allocated */
+  size_t peak_bytes;   /*!< Highest value of bytes */
+  size_t total_bytes;  /*!< Bytes requested by all the allocations and resizes */
+} AllocStats;
+
+#ifdef ALLOC_STATS
+
+void *alloc_malloc(AllocTag tag, size_t size);
+void *alloc_calloc(AllocTag tag, size_t n, size_t size);
+void *alloc_realloc(AllocTag tag, void *p, size_t size);
+void alloc_free(void *p);
+
+#else
+
+#define alloc_malloc(tag, size) malloc(size)
+#define alloc_calloc(tag, n, size) calloc((n), (size))
+#define alloc_realloc(tag, p, size) realloc((p), (size))
+#define alloc_free(p) free(p)
+
+#endif
+
+/**
+ * @brief Gets the counters of a tag.
+ *
+ * @param tag Tag, or ALLOC_TAGS for the sum of all of them (whose peak is
+ * the peak of the sum, not the sum of the peaks).
+ * @param stats Output, counters of the tag.
+ *
+ * @return OK, or ERROR if the accounting is not built in or the tag is
+ * not valid.
+ */
+Status alloc_getStats(AllocTag tag, AllocStats *stats);
+
+/**
+ * @brief Prints the counters of every tag, one per line.
+ *
+ * @param pf File descriptor.
+ *
+ * @return The number of characters printed, or -1 if there is any error
+ * or the accounting is not built in.
+ */
+int alloc_print(FILE *pf);
+
+#endif /* ALLOC_H */
@@ -1,8 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
 #include "bstree.h"
 #include "music.h"
+#include "perf.h"
+#include "trace.h"
 
 /* START [_BSTNode] */
 typedef struct _BSTNode {
@@ -42,7 +45,7 @@ static int _tree_countLongSongs_rec(BSTNode *node, int min_duration);
 static BSTNode *_bst_node_new(void) {
   BSTNode *pn = NULL;
 
-  pn = malloc(sizeof(BSTNode));
+  pn = alloc_malloc(ALLOC_TREE, sizeof(BSTNode));
   if (!pn) {
     return NULL;
   }
@@ -59,7 +62,7 @@ static void _bst_node_free(BSTNode *pn) {
     return;
   }
 
-  free(pn);
+  alloc_free(pn);
 }
 
 static void _bst_node_free_rec(BSTNode *pn) {
@@ -154,7 +157,7 @@ BSTree *tree_init(P_ele_print print_ele, P_ele_cmp cmp_ele) {
     return NULL;
   }
 
-  tree = malloc(sizeof(BSTree));
+  tree = alloc_malloc(ALLOC_TREE, sizeof(BSTree));
   if (!tree) {
     return NULL;
   }
@@ -172,7 +175,7 @@ void tree_destroy(BSTree *tree) {
   }
 
   _bst_node_free_rec(tree->root);
-  free(tree);
+  alloc_free(tree);
 
   return;
 }
@@ -361,11 +364,17 @@ void *tree_find_max(BSTree *tree) {
 }
 
 Bool tree_contains(BSTree *tree, const void *elem) {
+  Bool found;
+
   if (!tree || !elem) {
     return FALSE;
   }
 
-  return _bst_contains_rec(tree->root, elem, tree->cmp_ele);
+  trace_begin("tree_contains");
+  found = _bst_contains_rec(tree->root, elem, tree->cmp_ele);
+  trace_end("tree_contains");
+
+  return found;
 }
 
 Status tree_insert(BSTree *tree, const void *elem) {
@@ -375,7 +384,9 @@ Status tree_insert(BSTree *tree, const void *elem) {
     return ERROR;
   }
 
+  trace_begin("tree_insert");
   tree->root = _bst_insert_rec(tree->root, elem, tree->cmp_ele, &status);
+  trace_end("tree_insert");
 
   return status;
 }
@@ -385,13 +396,16 @@ Status tree_remove(BSTree *tree, const void *elem) {
     return ERROR;
   }
 
+  trace_begin("tree_remove");
   tree->root = _bst_remove_rec(tree->root, elem, tree->cmp_ele);
+  trace_end("tree_remove");
 
   return OK;
 }
 
 List *tree_rangeSearch(const BSTree *tree, void *min, void *max) {
   List *list = NULL;
+  Status st;
 
   if (!tree || !min || !max) {
     return NULL;
@@ -406,7 +420,12 @@ List *tree_rangeSearch(const BSTree *tree, void *min, void *max) {
     return list;
   }
 
-  if (_tree_rangeSearch_rec(tree->root, min, max, list, tree->cmp_ele) == ERROR) {
+  trace_begin("tree_rangeSearch");
+  perf_begin(PERF_RANGE_SEARCH);
+  st = _tree_rangeSearch_rec(tree->root, min, max, list, tree->cmp_ele);
+  perf_end(PERF_RANGE_SEARCH);
+  trace_end("tree_rangeSearch");
+  if (st == ERROR) {
     list_free(list);
     return NULL;
   }
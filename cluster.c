@@ -0,0 +1,256 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cluster.h"
+#include "intersect.h"
+
+typedef struct _ClusterGraph {
+  int n;              /* Number of songs */
+  int *offsets;       /* CSR offsets of the outgoing relations */
+  int *targets;       /* Destinations of the outgoing relations */
+  int *degree;        /* Number of neighbours ignoring directions */
+  int *fwd_offsets;   /* CSR offsets of the oriented neighbours */
+  int *fwd;           /* Neighbours with a higher (degree, position) */
+  int max_fwd;        /* Longest oriented list */
+} ClusterGraph;
+
+typedef struct _ClusterWorker {
+  const ClusterGraph *g;
+  int first;          /* First song of the worker */
+  int step;           /* Distance between the songs of the worker */
+  long *triangles;    /* Local counters */
+  long *cycles;       /* Local counters, NULL if not needed */
+  long total;
+  Status status;
+} ClusterWorker;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static ClusterGraph *cluster_graphNew(const Radio *r);
+static void cluster_graphFree(ClusterGraph *g);
+static Bool cluster_hasRelation(const ClusterGraph *g, int a, int b);
+static void *cluster_count(void *arg);
+
+static ClusterGraph *cluster_graphNew(const Radio *r) {
+  ClusterGraph *g;
+  int *in_offsets = NULL, *in_sources = NULL, *fill = NULL, *und = NULL;
+  int i, k, j, l, v, m, d;
+
+  g = (ClusterGraph *)calloc(1, sizeof(ClusterGraph));
+  if (!g) return NULL;
+
+  if (radio_getAdjacency(r, &g->n, &g->offsets, &g->targets) == ERROR) {
+    free(g);
+    return NULL;
+  }
+  m = g->offsets[g->n];
+
+  in_offsets = (int *)calloc(g->n + 1, sizeof(int));
+  in_sources = (int *)malloc(sizeof(int) * (m > 0 ? m : 1));
+  fill = (int *)malloc(sizeof(int) * (g->n > 0 ? g->n : 1));
+  und = (int *)malloc(sizeof(int) * (2 * m > 0 ? 2 * m : 1));
+  g->degree = (int *)calloc(g->n > 0 ? g->n : 1, sizeof(int));
+  g->fwd_offsets = (int *)calloc(g->n + 1, sizeof(int));
+  g->fwd = (int *)malloc(sizeof(int) * (m > 0 ? m : 1));
+  if (!in_offsets || !in_sources || !fill || !und || !g->degree || !g->fwd_offsets || !g->fwd) {
+    free(in_offsets);
+    free(in_sources);
+    free(fill);
+    free(und);
+    cluster_graphFree(g);
+    return NULL;
+  }
+
+  /* Incoming relations, sorted by origin because origins are visited in order */
+  for (k = 0; k < m; k++) in_offsets[g->targets[k] + 1]++;
+  for (i = 0; i < g->n; i++) {
+    in_offsets[i + 1] += in_offsets[i];
+    fill[i] = in_offsets[i];
+  }
+  for (i = 0; i < g->n; i++) {
+    for (k = g->offsets[i]; k < g->offsets[i + 1]; k++) in_sources[fill[g->targets[k]]++] = i;
+  }
+
+  /* Neighbours ignoring directions: merge of both sorted lists, without self loops */
+  for (i = 0, d = 0; i < g->n; i++) {
+    fill[i] = d;
+    k = g->offsets[i];
+    j = in_offsets[i];
+    while (k < g->offsets[i + 1] || j < in_offsets[i + 1]) {
+      if (j >= in_offsets[i + 1] || (k < g->offsets[i + 1] && g->targets[k] <= in_sources[j])) {
+        v = g->targets[k++];
+        if (j < in_offsets[i + 1] && in_sources[j] == v) j++;
+      } else {
+        v = in_sources[j++];
+      }
+      if (v != i) und[d++] = v;
+    }
+    g->degree[i] = d - fill[i];
+  }
+
+  /* Orientation by (degree, position): every list keeps its increasing order */
+  for (i = 0, l = 0; i < g->n; i++) {
+    g->fwd_offsets[i] = l;
+    for (k = fill[i]; k < fill[i] + g->degree[i]; k++) {
+      v = und[k];
+      if (g->degree[v] > g->degree[i] || (g->degree[v] == g->degree[i] && v > i)) g->fwd[l++] = v;
+    }
+    if (l - g->fwd_offsets[i] > g->max_fwd) g->max_fwd = l - g->fwd_offsets[i];
+  }
+  g->fwd_offsets[g->n] = l;
+
+  free(in_offsets);
+  free(in_sources);
+  free(fill);
+  free(und);
+
+  return g;
+}
+
+static void cluster_graphFree(ClusterGraph *g) {
+  if (!g) return;
+
+  free(g->offsets);
+  free(g->targets);
+  free(g->degree);
+  free(g->fwd_offsets);
+  free(g->fwd);
+  free(g);
+}
+
+static Bool cluster_hasRelation(const ClusterGraph *g, int a, int b) {
+  int low = g->offsets[a], high = g->offsets[a + 1], mid;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (g->targets[mid] < b) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return (low < g->offsets[a + 1] && g->targets[low] == b) ? TRUE : FALSE;
+}
+
+static void *cluster_count(void *arg) {
+  ClusterWorker *w = (ClusterWorker *)arg;
+  const ClusterGraph *g = w->g;
+  int *common;
+  int u, v, k, c, n_common, x;
+  long n_cycles;
+
+  w->status = ERROR;
+
+  common = (int *)malloc(sizeof(int) * (g->max_fwd > 0 ? g->max_fwd : 1));
+  if (!common) return NULL;
+
+  for (u = w->first; u < g->n; u += w->step) {
+    for (k = g->fwd_offsets[u]; k < g->fwd_offsets[u + 1]; k++) {
+      v = g->fwd[k];
+      n_common = intersect_list(&g->fwd[g->fwd_offsets[u]], g->fwd_offsets[u + 1] - g->fwd_offsets[u],
+                                &g->fwd[g->fwd_offsets[v]], g->fwd_offsets[v + 1] - g->fwd_offsets[v],
+                                common);
+      for (c = 0; c < n_common; c++) {
+        x = common[c];
+        w->triangles[u]++;
+        w->triangles[v]++;
+        w->triangles[x]++;
+        w->total++;
+
+        if (!w->cycles) continue;
+        n_cycles = 0;
+        if (cluster_hasRelation(g, u, v) && cluster_hasRelation(g, v, x) &&
+            cluster_hasRelation(g, x, u)) {
+          n_cycles++;
+        }
+        if (cluster_hasRelation(g, u, x) && cluster_hasRelation(g, x, v) &&
+            cluster_hasRelation(g, v, u)) {
+          n_cycles++;
+        }
+        w->cycles[u] += n_cycles;
+        w->cycles[v] += n_cycles;
+        w->cycles[x] += n_cycles;
+      }
+    }
+  }
+
+  free(common);
+  w->status = OK;
+
+  return NULL;
+}
+
+/*----------------------------------------------------------------------------------------*/
+long cluster_triangles(const Radio *r, int n_threads, long *triangles, long *cycles,
+                       double *coefficients) {
+  ClusterGraph *g;
+  ClusterWorker *w;
+  pthread_t *threads;
+  long total = 0, t_v;
+  int t, v, started = 0;
+  Status st = OK;
+
+  if (!r || n_threads <= 0) return -1;
+
+  g = cluster_graphNew(r);
+  if (!g) return -1;
+  if (n_threads > g->n) n_threads = (g->n > 0) ? g->n : 1;
+
+  w = (ClusterWorker *)calloc(n_threads, sizeof(ClusterWorker));
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * n_threads);
+  if (!w || !threads) st = ERROR;
+
+  for (t = 0; st == OK && t < n_threads; t++) {
+    w[t].g = g;
+    w[t].first = t;
+    w[t].step = n_threads;
+    w[t].triangles = (long *)calloc(g->n > 0 ? g->n : 1, sizeof(long));
+    if (cycles) w[t].cycles = (long *)calloc(g->n > 0 ? g->n : 1, sizeof(long));
+    if (!w[t].triangles || (cycles && !w[t].cycles)) st = ERROR;
+  }
+
+  if (st == OK) {
+    /* Songs are dealt round-robin, so hubs spread among the workers */
+    for (t = 1; t < n_threads; t++) {
+      if (pthread_create(&threads[t], NULL, cluster_count, &w[t]) != 0) break;
+      started++;
+    }
+    for (t = started + 1; t < n_threads; t++) cluster_count(&w[t]);
+    cluster_count(&w[0]);
+    for (t = 1; t <= started; t++) pthread_join(threads[t], NULL);
+
+    for (t = 0; t < n_threads; t++) {
+      if (w[t].status == ERROR) st = ERROR;
+      total += w[t].total;
+    }
+  }
+
+  for (v = 0; st == OK && v < g->n; v++) {
+    t_v = 0;
+    for (t = 0; t < n_threads; t++) t_v += w[t].triangles[v];
+    if (triangles) triangles[v] = t_v;
+    if (coefficients) {
+      coefficients[v] = (g->degree[v] > 1)
+                            ? 2.0 * t_v / ((double)g->degree[v] * (g->degree[v] - 1))
+                            : 0.0;
+    }
+    if (cycles) {
+      cycles[v] = 0;
+      for (t = 0; t < n_threads; t++) cycles[v] += w[t].cycles[v];
+    }
+  }
+
+  for (t = 0; w && t < n_threads; t++) {
+    free(w[t].triangles);
+    free(w[t].cycles);
+  }
+  free(w);
+  free(threads);
+  cluster_graphFree(g);
+
+  return (st == OK) ? total : -1;
+}
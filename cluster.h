@@ -0,0 +1,47 @@
+/**
+ * @file cluster.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Triangle counting and clustering coefficients over a radio
+ *
+ * @details A triangle is a set of three music related pairwise, ignoring
+ * the direction of the relations. A directed cycle is a triangle whose
+ * relations can be followed from one music back to itself
+ * (a -> b -> c -> a). The local clustering coefficient of a music is the
+ * fraction of pairs of its neighbours that are related.
+ *
+ * All the arrays are indexed by song position (see radio_getMusicAt).
+ *
+ * @see radio.h
+ */
+
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "radio.h"
+#include "types.h"
+
+/**
+ * @brief Counts the triangles of a radio.
+ *
+ * Every relation is oriented from the music with the lowest degree to the
+ * one with the highest degree, so that each triangle is found exactly once
+ * by intersecting two short sorted neighbour lists. The music are split
+ * among n_threads threads, each one with its own counters.
+ *
+ * @param r Pointer to the radio.
+ * @param n_threads Number of threads (1 means no extra threads).
+ * @param triangles Output array with the number of triangles of each
+ * music (can be NULL).
+ * @param cycles Output array with the number of directed cycles of
+ * length 3 through each music (can be NULL).
+ * @param coefficients Output array with the local clustering coefficient
+ * of each music, 0 for music with less than two neighbours (can be NULL).
+ *
+ * @return The total number of triangles, or -1 if there is any error.
+ */
+long cluster_triangles(const Radio *r, int n_threads, long *triangles, long *cycles,
+                       double *coefficients);
+
+#endif /* CLUSTER_H */
@@ -0,0 +1,273 @@
+#include <limits.h>
+#include <stdlib.h>
+
+#include "compact.h"
+
+struct _CompactGraph {
+  unsigned char *lists;   /* Encoded relation lists, one after another */
+  unsigned int *offsets;  /* Start of the list of every music in lists */
+  int num_music;          /* Number of music */
+  long num_relations;     /* Number of relations */
+};
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static size_t compact_varintSize(unsigned int x);
+static unsigned char *compact_writeVarint(unsigned char *p, unsigned int x);
+static unsigned int compact_readVarint(const unsigned char **p);
+static unsigned int compact_zigzag(int x);
+static int compact_unzigzag(unsigned int x);
+static size_t compact_listSize(int origin, const int *dest, int n);
+
+static size_t compact_varintSize(unsigned int x) {
+  size_t size = 1;
+
+  while (x >= 0x80) {
+    x >>= 7;
+    size++;
+  }
+
+  return size;
+}
+
+static unsigned char *compact_writeVarint(unsigned char *p, unsigned int x) {
+  while (x >= 0x80) {
+    *p++ = (unsigned char)(x | 0x80);
+    x >>= 7;
+  }
+  *p++ = (unsigned char)x;
+
+  return p;
+}
+
+static unsigned int compact_readVarint(const unsigned char **p) {
+  unsigned int x = 0;
+  int shift = 0;
+
+  while (**p & 0x80) {
+    x |= (unsigned int)(**p & 0x7F) << shift;
+    shift += 7;
+    (*p)++;
+  }
+  x |= (unsigned int)**p << shift;
+  (*p)++;
+
+  return x;
+}
+
+/* Small distances of any sign become small unsigned numbers: 0, -1, 1, -2... */
+static unsigned int compact_zigzag(int x) {
+  return (x >= 0) ? 2 * (unsigned int)x : 2 * (unsigned int)(-(long)x) - 1;
+}
+
+static int compact_unzigzag(unsigned int x) {
+  return (x & 1) ? -(int)((x >> 1) + 1) : (int)(x >> 1);
+}
+
+static size_t compact_listSize(int origin, const int *dest, int n) {
+  size_t size;
+  int k;
+
+  size = compact_varintSize((unsigned int)n);
+  if (n > 0) size += compact_varintSize(compact_zigzag(dest[0] - origin));
+  for (k = 1; k < n; k++) {
+    size += compact_varintSize((unsigned int)(dest[k] - dest[k - 1] - 1));
+  }
+
+  return size;
+}
+
+/*----------------------------------------------------------------------------------------*/
+CompactGraph *compact_new(const Radio *r) {
+  CompactGraph *g;
+  int *offsets = NULL, *targets = NULL;
+  unsigned char *p;
+  size_t size = 0;
+  int n, v, k;
+
+  if (!r) return NULL;
+
+  if (radio_getAdjacency(r, &n, &offsets, &targets) == ERROR) return NULL;
+
+  for (v = 0; v < n; v++) {
+    size += compact_listSize(v, targets + offsets[v], offsets[v + 1] - offsets[v]);
+  }
+
+  /* Offsets take 32 bits, half of a size_t, which matters with few relations per music */
+  g = (size <= UINT_MAX) ? (CompactGraph *)malloc(sizeof(CompactGraph)) : NULL;
+  if (g) {
+    g->lists = (unsigned char *)malloc(size > 0 ? size : 1);
+    g->offsets = (unsigned int *)malloc(sizeof(unsigned int) * (n + 1));
+  }
+  if (!g || !g->lists || !g->offsets) {
+    if (g) {
+      free(g->lists);
+      free(g->offsets);
+    }
+    free(g);
+    free(offsets);
+    free(targets);
+    return NULL;
+  }
+
+  g->num_music = n;
+  g->num_relations = offsets[n];
+
+  p = g->lists;
+  for (v = 0; v < n; v++) {
+    g->offsets[v] = (unsigned int)(p - g->lists);
+    p = compact_writeVarint(p, (unsigned int)(offsets[v + 1] - offsets[v]));
+    for (k = offsets[v]; k < offsets[v + 1]; k++) {
+      if (k == offsets[v]) {
+        p = compact_writeVarint(p, compact_zigzag(targets[k] - v));
+      } else {
+        p = compact_writeVarint(p, (unsigned int)(targets[k] - targets[k - 1] - 1));
+      }
+    }
+  }
+  g->offsets[n] = (unsigned int)(p - g->lists);
+
+  free(offsets);
+  free(targets);
+
+  return g;
+}
+
+void compact_free(CompactGraph *g) {
+  if (!g) return;
+
+  free(g->lists);
+  free(g->offsets);
+  free(g);
+}
+
+int compact_getNumberOfMusic(const CompactGraph *g) {
+  if (!g) return -1;
+
+  return g->num_music;
+}
+
+long compact_getNumberOfRelations(const CompactGraph *g) {
+  if (!g) return -1;
+
+  return g->num_relations;
+}
+
+int compact_getNumberOfRelationsAt(const CompactGraph *g, int index) {
+  const unsigned char *p;
+
+  if (!g || index < 0 || index >= g->num_music) return -1;
+
+  p = g->lists + g->offsets[index];
+
+  return (int)compact_readVarint(&p);
+}
+
+int compact_getRelationsAt(const CompactGraph *g, int index, int *dest) {
+  const unsigned char *p;
+  int n, k;
+
+  if (!g || !dest || index < 0 || index >= g->num_music) return -1;
+
+  p = g->lists + g->offsets[index];
+  n = (int)compact_readVarint(&p);
+  for (k = 0; k < n; k++) {
+    if (k == 0) {
+      dest[k] = index + compact_unzigzag(compact_readVarint(&p));
+    } else {
+      dest[k] = dest[k - 1] + (int)compact_readVarint(&p) + 1;
+    }
+  }
+
+  return n;
+}
+
+size_t compact_getMemorySize(const CompactGraph *g) {
+  if (!g) return 0;
+
+  return sizeof(CompactGraph) + sizeof(unsigned int) * (g->num_music + 1) +
+         g->offsets[g->num_music];
+}
+
+double compact_getBitsPerRelation(const CompactGraph *g) {
+  if (!g) return -1;
+  if (g->num_relations == 0) return 0;
+
+  return 8.0 * (sizeof(unsigned int) * (g->num_music + 1) + g->offsets[g->num_music]) /
+         g->num_relations;
+}
+
+int compact_breadthSearch(const CompactGraph *g, int from, int *order) {
+  const unsigned char *p;
+  char *visited;
+  int head = 0, tail = 0, v, w, n, k;
+
+  if (!g || !order || from < 0 || from >= g->num_music) return -1;
+
+  visited = (char *)calloc(g->num_music > 0 ? g->num_music : 1, sizeof(char));
+  if (!visited) return -1;
+
+  /* The visit order is also the queue: music are appended when first seen */
+  visited[from] = 1;
+  order[tail++] = from;
+
+  while (head < tail) {
+    v = order[head++];
+    p = g->lists + g->offsets[v];
+    n = (int)compact_readVarint(&p);
+    for (k = 0, w = v; k < n; k++) {
+      w = (k == 0) ? v + compact_unzigzag(compact_readVarint(&p))
+                   : w + (int)compact_readVarint(&p) + 1;
+      if (!visited[w]) {
+        visited[w] = 1;
+        order[tail++] = w;
+      }
+    }
+  }
+
+  free(visited);
+
+  return tail;
+}
+
+int compact_depthSearch(const CompactGraph *g, int from, int *order) {
+  const unsigned char *p;
+  char *visited;
+  int *stack;
+  int top = 0, count = 0, v, w, n, k;
+
+  if (!g || !order || from < 0 || from >= g->num_music) return -1;
+
+  visited = (char *)calloc(g->num_music > 0 ? g->num_music : 1, sizeof(char));
+  stack = (int *)malloc(sizeof(int) * (g->num_music > 0 ? g->num_music : 1));
+  if (!visited || !stack) {
+    free(visited);
+    free(stack);
+    return -1;
+  }
+
+  visited[from] = 1;
+  stack[top++] = from;
+
+  while (top > 0) {
+    v = stack[--top];
+    order[count++] = v;
+    p = g->lists + g->offsets[v];
+    n = (int)compact_readVarint(&p);
+    for (k = 0, w = v; k < n; k++) {
+      w = (k == 0) ? v + compact_unzigzag(compact_readVarint(&p))
+                   : w + (int)compact_readVarint(&p) + 1;
+      if (!visited[w]) {
+        visited[w] = 1;
+        stack[top++] = w;
+      }
+    }
+  }
+
+  free(visited);
+  free(stack);
+
+  return count;
+}
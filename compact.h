@@ -0,0 +1,138 @@
+/**
+ * @file compact.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Compressed read-only copy of the relations of a radio
+ *
+ * @details The destinations of the relations leaving each music are kept
+ * sorted by position and stored as gaps encoded with varints (7 bits per
+ * byte, the highest bit set in every byte but the last). Each list starts
+ * with its length; the first destination is stored as its signed distance
+ * to the origin music, so relations between nearby music take one byte.
+ * Lists are decoded on the fly while searching. The start of every list
+ * is kept as a 32-bit offset, so the lists may take up to 4 GiB.
+ *
+ * Songs are identified by their position, as in radio_getAdjacency.
+ *
+ * @see radio.h
+ */
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stddef.h>
+
+#include "radio.h"
+#include "types.h"
+
+typedef struct _CompactGraph CompactGraph;
+
+/**
+ * @brief Creates a compressed copy of the relations of a radio.
+ *
+ * @param r Pointer to the radio.
+ *
+ * @return A pointer to the compressed relations, or NULL if there is any
+ * error or the lists would not fit in 4 GiB.
+ */
+CompactGraph *compact_new(const Radio *r);
+
+/**
+ * @brief Frees a compressed copy of the relations of a radio.
+ *
+ * @param g Pointer to the compressed relations.
+ */
+void compact_free(CompactGraph *g);
+
+/**
+ * @brief Gets the number of music.
+ *
+ * @param g Pointer to the compressed relations.
+ *
+ * @return The number of music, or -1 if there is any error.
+ */
+int compact_getNumberOfMusic(const CompactGraph *g);
+
+/**
+ * @brief Gets the number of relations.
+ *
+ * @param g Pointer to the compressed relations.
+ *
+ * @return The number of relations, or -1 if there is any error.
+ */
+long compact_getNumberOfRelations(const CompactGraph *g);
+
+/**
+ * @brief Gets the number of relations leaving the music at a position.
+ *
+ * @param g Pointer to the compressed relations.
+ * @param index Position of the music.
+ *
+ * @return The number of relations, or -1 if there is any error.
+ */
+int compact_getNumberOfRelationsAt(const CompactGraph *g, int index);
+
+/**
+ * @brief Decodes the relations leaving the music at a position.
+ *
+ * @param g Pointer to the compressed relations.
+ * @param index Position of the music.
+ * @param dest Output, positions of the destinations in increasing order;
+ * needs room for compact_getNumberOfRelationsAt values.
+ *
+ * @return The number of relations, or -1 if there is any error.
+ */
+int compact_getRelationsAt(const CompactGraph *g, int index, int *dest);
+
+/**
+ * @brief Gets the memory used by the compressed relations.
+ *
+ * @param g Pointer to the compressed relations.
+ *
+ * @return The number of bytes of the lists, their offsets and the
+ * structure, or 0 if there is any error.
+ */
+size_t compact_getMemorySize(const CompactGraph *g);
+
+/**
+ * @brief Gets the average size of an encoded relation.
+ *
+ * The encoded lists and their offsets are counted, so the result can be
+ * compared with the whole size of a CSR.
+ *
+ * @param g Pointer to the compressed relations.
+ *
+ * @return The number of bits per relation (0 if there are no relations),
+ * or -1 if there is any error.
+ */
+double compact_getBitsPerRelation(const CompactGraph *g);
+
+/**
+ * @brief Makes a breadth-first search from a music.
+ *
+ * @param g Pointer to the compressed relations.
+ * @param from Position of the origin music.
+ * @param order Output, positions of the music in the order they are
+ * visited; needs room for compact_getNumberOfMusic values.
+ *
+ * @return The number of music visited, or -1 if there is any error.
+ */
+int compact_breadthSearch(const CompactGraph *g, int from, int *order);
+
+/**
+ * @brief Makes a depth-first search from a music.
+ *
+ * Music are marked when they are pushed, as in radio_depthSearch, so the
+ * stack never holds more than one copy of each music.
+ *
+ * @param g Pointer to the compressed relations.
+ * @param from Position of the origin music.
+ * @param order Output, positions of the music in the order they are
+ * visited; needs room for compact_getNumberOfMusic values.
+ *
+ * @return The number of music visited, or -1 if there is any error.
+ */
+int compact_depthSearch(const CompactGraph *g, int from, int *order);
+
+#endif /* COMPACT_H */
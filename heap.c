@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+struct _Heap {
+  int *items;     /*!< Items in heap order */
+  double *keys;   /*!< Keys in heap order */
+  int *position;  /*!< Position of every item in items, -1 if absent */
+  int size;       /*!< Number of items in the heap */
+  int capacity;   /*!< Maximum number of items */
+};
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static void heap_swap(Heap *h, int i, int j);
+static void heap_siftUp(Heap *h, int i);
+static void heap_siftDown(Heap *h, int i);
+
+static void heap_swap(Heap *h, int i, int j) {
+  int item;
+  double key;
+
+  item = h->items[i];
+  h->items[i] = h->items[j];
+  h->items[j] = item;
+
+  key = h->keys[i];
+  h->keys[i] = h->keys[j];
+  h->keys[j] = key;
+
+  h->position[h->items[i]] = i;
+  h->position[h->items[j]] = j;
+}
+
+static void heap_siftUp(Heap *h, int i) {
+  int parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (h->keys[parent] <= h->keys[i]) break;
+    heap_swap(h, i, parent);
+    i = parent;
+  }
+}
+
+static void heap_siftDown(Heap *h, int i) {
+  int child;
+
+  while ((child = 2 * i + 1) < h->size) {
+    if (child + 1 < h->size && h->keys[child + 1] < h->keys[child]) child++;
+    if (h->keys[i] <= h->keys[child]) break;
+    heap_swap(h, i, child);
+    i = child;
+  }
+}
+
+/*----------------------------------------------------------------------------------------*/
+Heap *heap_new(int capacity) {
+  Heap *h;
+  int i;
+
+  if (capacity < 0) return NULL;
+
+  h = (Heap *)malloc(sizeof(Heap));
+  if (!h) return NULL;
+
+  h->items = (int *)malloc(sizeof(int) * (capacity > 0 ? capacity : 1));
+  h->keys = (double *)malloc(sizeof(double) * (capacity > 0 ? capacity : 1));
+  h->position = (int *)malloc(sizeof(int) * (capacity > 0 ? capacity : 1));
+  if (!h->items || !h->keys || !h->position) {
+    heap_free(h);
+    return NULL;
+  }
+
+  for (i = 0; i < capacity; i++) {
+    h->position[i] = -1;
+  }
+
+  h->size = 0;
+  h->capacity = capacity;
+
+  return h;
+}
+
+void heap_free(Heap *h) {
+  if (!h) return;
+
+  free(h->items);
+  free(h->keys);
+  free(h->position);
+  free(h);
+}
+
+void heap_clear(Heap *h) {
+  int i;
+
+  if (!h) return;
+
+  for (i = 0; i < h->size; i++) {
+    h->position[h->items[i]] = -1;
+  }
+  h->size = 0;
+}
+
+Bool heap_isEmpty(const Heap *h) {
+  if (!h || h->size == 0) return TRUE;
+
+  return FALSE;
+}
+
+size_t heap_size(const Heap *h) {
+  if (!h) return 0;
+
+  return (size_t)h->size;
+}
+
+Status heap_push(Heap *h, int item, double key) {
+  int i;
+
+  if (!h || item < 0 || item >= h->capacity) return ERROR;
+
+  i = h->position[item];
+  if (i >= 0) {
+    if (key < h->keys[i]) {
+      h->keys[i] = key;
+      heap_siftUp(h, i);
+    }
+    return OK;
+  }
+
+  i = h->size++;
+  h->items[i] = item;
+  h->keys[i] = key;
+  h->position[item] = i;
+  heap_siftUp(h, i);
+
+  return OK;
+}
+
+int heap_pop(Heap *h, double *key) {
+  int item;
+
+  if (!h || h->size == 0) return -1;
+
+  item = h->items[0];
+  if (key) *key = h->keys[0];
+
+  heap_swap(h, 0, h->size - 1);
+  h->size--;
+  h->position[item] = -1;
+  heap_siftDown(h, 0);
+
+  return item;
+}
+
+int heap_top(const Heap *h, double *key) {
+  if (!h || h->size == 0) return -1;
+
+  if (key) *key = h->keys[0];
+
+  return h->items[0];
+}
+
+Bool heap_contains(const Heap *h, int item) {
+  if (!h || item < 0 || item >= h->capacity) return FALSE;
+
+  return (h->position[item] >= 0) ? TRUE : FALSE;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file heap.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Indexed binary min-heap of integer items
+ *
+ * @details The items are integers in [0, capacity) (typically song
+ * positions inside a radio) and each one has a double key. An item can be
+ * in the heap only once; pushing it again lowers its key if the new key is
+ * smaller (decrease-key), which is what Dijkstra-like searches need.
+ *
+ * @see radio.h
+ */
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+typedef struct _Heap Heap;
+
+/**
+ * @brief Creates an empty heap.
+ *
+ * @param capacity Number of different items the heap can hold; the
+ * items must be in [0, capacity).
+ *
+ * @return A pointer to the heap, or NULL if there is any error.
+ */
+Heap *heap_new(int capacity);
+
+/**
+ * @brief Frees a heap.
+ *
+ * @param h Pointer to the heap.
+ */
+void heap_free(Heap *h);
+
+/**
+ * @brief Removes every item from a heap in O(size).
+ *
+ * @param h Pointer to the heap.
+ */
+void heap_clear(Heap *h);
+
+/**
+ * @brief Checks if a heap is empty.
+ *
+ * @param h Pointer to the heap.
+ *
+ * @return TRUE if the heap is empty or NULL, FALSE otherwise.
+ */
+Bool heap_isEmpty(const Heap *h);
+
+/**
+ * @brief Returns the number of items in a heap.
+ *
+ * @param h Pointer to the heap.
+ *
+ * @return The number of items, or 0 if the heap is NULL.
+ */
+size_t heap_size(const Heap *h);
+
+/**
+ * @brief Inserts an item or lowers its key.
+ *
+ * If the item is already in the heap, its key is only updated when the
+ * new key is smaller.
+ *
+ * @param h Pointer to the heap.
+ * @param item Item to insert, in [0, capacity).
+ * @param key Key of the item.
+ *
+ * @return OK or ERROR.
+ */
+Status heap_push(Heap *h, int item, double key);
+
+/**
+ * @brief Extracts the item with the smallest key.
+ *
+ * @param h Pointer to the heap.
+ * @param key Output, key of the extracted item (can be NULL).
+ *
+ * @return The extracted item, or -1 if the heap is empty or NULL.
+ */
+int heap_pop(Heap *h, double *key);
+
+/**
+ * @brief Returns the item with the smallest key without extracting it.
+ *
+ * @param h Pointer to the heap.
+ * @param key Output, key of the item (can be NULL).
+ *
+ * @return The item with the smallest key, or -1 if the heap is empty or
+ * NULL.
+ */
+int heap_top(const Heap *h, double *key);
+
+/**
+ * @brief Checks if an item is in a heap.
+ *
+ * @param h Pointer to the heap.
+ * @param item Item to look for.
+ *
+ * @return TRUE if the item is in the heap, FALSE otherwise.
+ */
+Bool heap_contains(const Heap *h, int item);
+
+#endif /* HEAP_H */
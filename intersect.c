@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "intersect.h"
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static int intersect_gallop(const int *a, int na, const int *b, int nb, int *out);
+static int intersect_merge(const int *a, int na, const int *b, int nb, int *out);
+static int intersect_lowerBound(const int *b, int low, int nb, int x);
+
+/* First position in [low, nb) with b[pos] >= x, by exponential then binary search */
+static int intersect_lowerBound(const int *b, int low, int nb, int x) {
+  int step = 1, high = low, mid;
+
+  while (high < nb && b[high] < x) {
+    low = high + 1;
+    high += step;
+    step *= 2;
+  }
+  if (high > nb) high = nb;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (b[mid] < x) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+/* a is the small set */
+static int intersect_gallop(const int *a, int na, const int *b, int nb, int *out) {
+  int i, j = 0, count = 0;
+
+  for (i = 0; i < na && j < nb; i++) {
+    j = intersect_lowerBound(b, j, nb, a[i]);
+    if (j < nb && b[j] == a[i]) {
+      if (out) out[count] = a[i];
+      count++;
+      j++;
+    }
+  }
+
+  return count;
+}
+
+static int intersect_merge(const int *a, int na, const int *b, int nb, int *out) {
+  int i = 0, j = 0, count = 0, lt;
+
+  while (i < na && j < nb) {
+    /* Skip whole blocks that end before the other set's current element */
+    if (i + INTERSECT_BLOCK <= na && a[i + INTERSECT_BLOCK - 1] < b[j]) {
+      i += INTERSECT_BLOCK;
+      continue;
+    }
+    if (j + INTERSECT_BLOCK <= nb && b[j + INTERSECT_BLOCK - 1] < a[i]) {
+      j += INTERSECT_BLOCK;
+      continue;
+    }
+
+    if (a[i] == b[j]) {
+      if (out) out[count] = a[i];
+      count++;
+      i++;
+      j++;
+    } else {
+      /* Branch-free advance of the smallest side */
+      lt = (a[i] < b[j]);
+      i += lt;
+      j += !lt;
+    }
+  }
+
+  return count;
+}
+
+/*----------------------------------------------------------------------------------------*/
+int intersect_count(const int *a, int na, const int *b, int nb) {
+  return intersect_list(a, na, b, nb, NULL);
+}
+
+int intersect_list(const int *a, int na, const int *b, int nb, int *out) {
+  if (na < 0 || nb < 0 || (na > 0 && !a) || (nb > 0 && !b)) return -1;
+  if (na == 0 || nb == 0) return 0;
+
+  if ((long)na * INTERSECT_GALLOP_RATIO < nb) return intersect_gallop(a, na, b, nb, out);
+  if ((long)nb * INTERSECT_GALLOP_RATIO < na) return intersect_gallop(b, nb, a, na, out);
+
+  return intersect_merge(a, na, b, nb, out);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file intersect.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Intersection of sorted integer sets
+ *
+ * @details The sets are arrays of integers sorted in increasing order and
+ * without repetitions, such as the relation lists of a radio. Sets of
+ * similar size are merged skipping blocks of INTERSECT_BLOCK elements that
+ * cannot match; when one set is much larger than the other, the elements
+ * of the small one are searched in the large one by galloping (exponential
+ * plus binary search).
+ *
+ * @see radio.h
+ */
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+/**
+ * @brief Number of elements compared at once while merging.
+ */
+#define INTERSECT_BLOCK 4
+
+/**
+ * @brief Size ratio from which galloping is used instead of merging.
+ */
+#define INTERSECT_GALLOP_RATIO 16
+
+/**
+ * @brief Counts the common elements of two sorted sets.
+ *
+ * @param a First set.
+ * @param na Number of elements of a.
+ * @param b Second set.
+ * @param nb Number of elements of b.
+ *
+ * @return The number of common elements, or -1 if there is any error.
+ */
+int intersect_count(const int *a, int na, const int *b, int nb);
+
+/**
+ * @brief Stores the common elements of two sorted sets.
+ *
+ * @param a First set.
+ * @param na Number of elements of a.
+ * @param b Second set.
+ * @param nb Number of elements of b.
+ * @param out Output array, with room for the smallest of na and nb
+ * elements. The common elements are stored in increasing order.
+ *
+ * @return The number of common elements, or -1 if there is any error.
+ */
+int intersect_list(const int *a, int na, const int *b, int nb, int *out);
+
+#endif /* INTERSECT_H */
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
 #include "list.h"
 
 typedef struct _Node Node;
@@ -27,7 +28,7 @@ static Node *node_new(const void *e) {
 
   if (!e) return NULL;
 
-  n = (Node *)malloc(sizeof(Node));
+  n = (Node *)alloc_malloc(ALLOC_LIST, sizeof(Node));
   if (!n) return NULL;
 
   n->info = (void *)e;
@@ -40,7 +41,7 @@ static Node *node_new(const void *e) {
 List *list_new() {
   List *pl;
 
-  pl = (List *)malloc(sizeof(List));
+  pl = (List *)alloc_malloc(ALLOC_LIST, sizeof(List));
   if (!pl) return NULL;
 
   pl->first = NULL;
@@ -105,7 +106,7 @@ void *list_popFront(List *pl) {
 
   if (!pl->first) pl->last = NULL;
 
-  free(aux);
+  alloc_free(aux);
   pl->size--;
 
   return info;
@@ -120,7 +121,7 @@ void *list_popBack(List *pl) {
 
   if (pl->first == pl->last) {
     info = pl->first->info;
-    free(pl->first);
+    alloc_free(pl->first);
     pl->first = NULL;
     pl->last = NULL;
     pl->size = 0;
@@ -137,7 +138,7 @@ void *list_popBack(List *pl) {
   previous->next = NULL;
   pl->last = previous;
 
-  free(aux);
+  alloc_free(aux);
   pl->size--;
 
   return info;
@@ -162,7 +163,7 @@ void list_free(List *pl) {
     list_popFront(pl);
   }
 
-  free(pl);
+  alloc_free(pl);
 }
 
 int list_size(const List *pl) {
@@ -12,11 +12,13 @@
 
 #include <string.h>
 #include <ctype.h>
+#include "alloc.h"
 #include "music.h"
 
 /* START [STR_LENGTH] */
 #define STR_LENGTH 64
 /* END [STR_LENGTH] */
+#define MUSIC_STATE_LENGTH 16
 
 /* Music declaration goes here */
 struct _Music {
@@ -43,7 +45,7 @@ static char *music_strdup(const char *src) {
   if (!src) return NULL;
 
   len = strlen(src) + 1;
-  copy = (char *)malloc(sizeof(char) * len);
+  copy = (char *)alloc_malloc(ALLOC_MUSIC, sizeof(char) * len);
   if (!copy) return NULL;
 
   strcpy(copy, src);
@@ -133,7 +135,7 @@ static Status music_setField(Music *m, char *key, char *value) {
 Music *music_init() {
   Music *m;
 
-  m = (Music *)malloc(sizeof(Music));
+  m = (Music *)alloc_malloc(ALLOC_MUSIC, sizeof(Music));
   if (!m) return NULL;
 
   m->id = 0;
@@ -170,7 +172,7 @@ Music *music_initFromString(char *descr) {
 
   m = music_init();
   if (!m) {
-    free(buffer);
+    alloc_free(buffer);
     return NULL;
   }
 
@@ -183,7 +185,7 @@ Music *music_initFromString(char *descr) {
     while (*cursor && *cursor != ':' && !isspace((unsigned char)*cursor)) cursor++;
     if (*cursor != ':') {
       music_free(m);
-      free(buffer);
+      alloc_free(buffer);
       return NULL;
     }
 
@@ -193,7 +195,7 @@ Music *music_initFromString(char *descr) {
     while (*cursor && isspace((unsigned char)*cursor)) cursor++;
     if (!*cursor) {
       music_free(m);
-      free(buffer);
+      alloc_free(buffer);
       return NULL;
     }
 
@@ -203,7 +205,7 @@ Music *music_initFromString(char *descr) {
       while (*cursor && *cursor != '"') cursor++;
       if (*cursor != '"') {
         music_free(m);
-        free(buffer);
+        alloc_free(buffer);
         return NULL;
       }
       *cursor = '\0';
@@ -219,15 +221,78 @@ Music *music_initFromString(char *descr) {
 
     if (music_setField(m, key, value) == ERROR) {
       music_free(m);
-      free(buffer);
+      alloc_free(buffer);
       return NULL;
     }
   }
 
-  free(buffer);
+  alloc_free(buffer);
   return m;
 }
 
+/**
+ * @brief Reads the id and the state of a Music description.
+ *
+ * @param descr String describing the Music.
+ * @param id Output, id of the Music.
+ * @param state Output, state of the Music.
+ *
+ * @return Returns OK or ERROR in case of error.
+ */
+Status music_scanDescription(const char *descr, long *id, State *state) {
+  const char *cursor;
+  const char *key;
+  const char *value;
+  char buffer[MUSIC_STATE_LENGTH];
+  size_t key_len;
+  size_t value_len;
+
+  if (!descr || !id || !state) return ERROR;
+
+  *id = 0;
+  *state = NOT_LISTENED;
+
+  cursor = descr;
+  while (*cursor) {
+    while (*cursor && isspace((unsigned char)*cursor)) cursor++;
+    if (!*cursor) break;
+
+    key = cursor;
+    while (*cursor && *cursor != ':' && !isspace((unsigned char)*cursor)) cursor++;
+    if (*cursor != ':') return ERROR;
+    key_len = (size_t)(cursor - key);
+    cursor++;
+
+    while (*cursor && isspace((unsigned char)*cursor)) cursor++;
+    if (!*cursor) return ERROR;
+
+    if (*cursor == '"') {
+      cursor++;
+      value = cursor;
+      while (*cursor && *cursor != '"') cursor++;
+      if (*cursor != '"') return ERROR;
+      value_len = (size_t)(cursor - value);
+      cursor++;
+    } else {
+      value = cursor;
+      while (*cursor && !isspace((unsigned char)*cursor)) cursor++;
+      value_len = (size_t)(cursor - value);
+    }
+
+    if (key_len == 2 && strncmp(key, "id", 2) == 0) {
+      *id = atol(value);
+      if (*id < 0) return ERROR;
+    } else if (key_len == 5 && strncmp(key, "state", 5) == 0) {
+      if (value_len >= sizeof(buffer)) return ERROR;
+      memcpy(buffer, value, value_len);
+      buffer[value_len] = '\0';
+      if (music_parseState(buffer, state) == ERROR) return ERROR;
+    }
+  }
+
+  return OK;
+}
+
 /**
  * @brief Destructor. Free the dynamic memory reserved for a Music.
  *
@@ -235,7 +300,7 @@ Music *music_initFromString(char *descr) {
  */
 void music_free(void *m) {
   if (!m) return;
-  free((Music *)m);
+  alloc_free((Music *)m);
 }
 
 /**
@@ -310,6 +375,19 @@ int music_getIndex(const Music *m) {
   return m->index;
 }
 
+/**
+ * @brief Gets the memory used by a Music.
+ *
+ * @param m Music pointer.
+ *
+ * @return Returns the number of bytes allocated for the Music, or 0 in
+ * case of error.
+ */
+size_t music_getMemorySize(const Music *m) {
+  if (!m) return 0;
+  return sizeof(Music);
+}
+
 /**
  * @brief Modifies the id of a given Music.
  *
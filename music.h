@@ -79,6 +79,22 @@ Music * music_init ();
 */
 Music *music_initFromString(char *descr);
 
+
+/**
+ * @brief Reads the id and the state of a Music description.
+ *
+ * Does not allocate a Music nor copy the other fields, which are only
+ * checked to be well formed key:value pairs (see music_initFromString).
+ * Missing fields take the values of music_init.
+ *
+ * @param descr String describing the Music.
+ * @param id Output, id of the Music.
+ * @param state Output, state of the Music.
+ *
+ * @return Returns OK or ERROR in case of error.
+ */
+Status music_scanDescription (const char * descr, long * id, State * state);
+
 /**
  * @brief Destructor. Free the dynamic memory reserved for a Music .
  *
@@ -148,6 +164,16 @@ State music_getState (const Music * m);
  */
 int music_getIndex (const Music * m);
 
+/**
+ * @brief Gets the memory used by a Music.
+ *
+ * @param m Music pointer
+ *
+ * @return Returns the number of bytes allocated for the Music, or 0 in
+ * case of error.
+ */
+size_t music_getMemorySize (const Music * m);
+
 
 /**
  * @brief Modifies the id of a given Music.
@@ -4,11 +4,16 @@
 #include "music.h"
 #include "queue.h"
 #include "radio.h"
+#include "walk.h"
+
+#define UPCOMING_SONGS 5
+#define NO_REPEAT_WINDOW 3
 
 int main(int argc, char **argv) {
   FILE *fin = NULL;
   Radio *radio = NULL;
   Queue *play_queue = NULL;
+  Walk *walk = NULL;
   Music *current_music = NULL;
   Music *m = NULL;
   char line[64];
@@ -17,8 +22,8 @@ int main(int argc, char **argv) {
   int option;
   int i;
 
-  if (argc != 2) {
-    fprintf(stderr, "Usage: %s <radio_file>\n", argv[0]);
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "Usage: %s <radio_file> [<seed_id> [<rng_seed>]]\n", argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -51,7 +56,20 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  for (i = 0; i < radio_getNumberOfMusic(radio); i++) {
+  /* With a seed song the queue is fed by a random walk ("radio mode") */
+  if (argc > 2) {
+    walk = walk_new(radio, atol(argv[2]), (argc > 3) ? strtoul(argv[3], NULL, 10) : 0,
+                    NO_REPEAT_WINDOW, NULL);
+    if (!walk || walk_fill(walk, play_queue, UPCOMING_SONGS + 1) == ERROR) {
+      fprintf(stderr, "Error: could not start radio mode from music %s\n", argv[2]);
+      walk_free(walk);
+      queue_free(play_queue);
+      radio_free(radio);
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (i = 0; !walk && i < radio_getNumberOfMusic(radio); i++) {
     m = radio_getMusicAt(radio, i);
     if (!m || queue_push(play_queue, m) == ERROR) {
       fprintf(stderr, "Error: could not enqueue music\n");
@@ -67,6 +85,7 @@ int main(int argc, char **argv) {
     if (current_music) {
       if (music_formatted_print(stdout, current_music) < 0) {
         fprintf(stderr, "Error: could not print current music\n");
+        walk_free(walk);
         queue_free(play_queue);
         radio_free(radio);
         return EXIT_FAILURE;
@@ -78,6 +97,7 @@ int main(int argc, char **argv) {
     printf("\nUpcoming:\n");
     if (queue_print(stdout, play_queue, music_plain_print) < 0) {
       fprintf(stderr, "Error: could not print playback queue\n");
+      walk_free(walk);
       queue_free(play_queue);
       radio_free(radio);
       return EXIT_FAILURE;
@@ -96,11 +116,19 @@ int main(int argc, char **argv) {
 
     if (option == 1) {
       current_music = (Music *)queue_pop(play_queue);
+      if (walk && walk_fill(walk, play_queue, UPCOMING_SONGS) == ERROR) {
+        fprintf(stderr, "Error: could not enqueue music\n");
+        walk_free(walk);
+        queue_free(play_queue);
+        radio_free(radio);
+        return EXIT_FAILURE;
+      }
     } else if (option != 2) {
       printf("Invalid option\n");
     }
   } while (option != 2);
 
+  walk_free(walk);
   queue_free(play_queue);
   radio_free(radio);
 
@@ -1,18 +1,162 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "radio.h"
+#include "trace.h"
+
+#define BATCH_LINE_SIZE 256
+#define BATCH_MAX_THREADS 64
+
+typedef struct {
+  Radio *radio;
+  FILE *pairs;
+  pthread_mutex_t in_mutex;   /* Protects pairs */
+  pthread_mutex_t out_mutex;  /* Keeps the answer of every pair together in stdout */
+  long answered;
+  long failed;
+} Batch;
+
+static Status searchPair(FILE *pf, Radio *radio, long from_id, long to_id);
+static void *batchWorker(void *arg);
+static int runBatch(Radio *radio, const char *filename, int n_threads);
+
+static Status searchPair(FILE *pf, Radio *radio, long from_id, long to_id) {
+  fprintf(pf, "-----------DFS-----------\n");
+  fprintf(pf, "From music id: %ld\n", from_id);
+  fprintf(pf, "To music id: %ld\n", to_id);
+  fprintf(pf, "Output:\n");
+  if (radio_printDepthSearch(pf, radio, from_id, to_id) == ERROR) return ERROR;
+
+  fprintf(pf, "-----------BFS-----------\n");
+  fprintf(pf, "From music id: %ld\n", from_id);
+  fprintf(pf, "To music id: %ld\n", to_id);
+  fprintf(pf, "Output:\n");
+  if (radio_printBreadthSearch(pf, radio, from_id, to_id) == ERROR) return ERROR;
+
+  return OK;
+}
+
+/* Answers pairs until the input ends. The searches reuse the workspace of the radio
+ * (or of the thread, in concurrent mode), and every answer is written to a buffer of
+ * the worker, so that it reaches stdout in one piece as soon as it is complete */
+static void *batchWorker(void *arg) {
+  Batch *b = (Batch *)arg;
+  char line[BATCH_LINE_SIZE];
+  char *buffer = NULL;
+  size_t size = 0;
+  FILE *out;
+  long from_id, to_id;
+  Status st;
+
+  while (1) {
+    pthread_mutex_lock(&b->in_mutex);
+    if (!fgets(line, sizeof(line), b->pairs)) {
+      pthread_mutex_unlock(&b->in_mutex);
+      break;
+    }
+    pthread_mutex_unlock(&b->in_mutex);
+
+    if (line[strspn(line, " \t\r\n")] == '\0' || line[0] == '#') continue;
+
+    out = open_memstream(&buffer, &size);
+    if (sscanf(line, "%ld %ld", &from_id, &to_id) != 2) {
+      st = ERROR;
+    } else {
+      trace_begin("batch_pair");
+      st = (out) ? searchPair(out, b->radio, from_id, to_id) : ERROR;
+      trace_end("batch_pair");
+    }
+    if (out) fclose(out);
+
+    pthread_mutex_lock(&b->out_mutex);
+    if (st == OK) {
+      fwrite(buffer, 1, size, stdout);
+      fflush(stdout);
+      b->answered++;
+    } else {
+      line[strcspn(line, "\r\n")] = '\0';
+      fprintf(stderr, "Error: could not search the pair \"%s\"\n", line);
+      b->failed++;
+    }
+    pthread_mutex_unlock(&b->out_mutex);
+
+    free(buffer);
+    buffer = NULL;
+    size = 0;
+  }
+
+  return NULL;
+}
+
+/* Answers every "from_id to_id" line of a file ("-" for stdin); returns the number of
+ * pairs that could not be answered, or -1 if the batch could not start */
+static int runBatch(Radio *radio, const char *filename, int n_threads) {
+  pthread_t threads[BATCH_MAX_THREADS];
+  Batch b;
+  int i, started = 0;
+
+  b.pairs = (strcmp(filename, "-") == 0) ? stdin : fopen(filename, "r");
+  if (!b.pairs) {
+    fprintf(stderr, "Error: could not open file %s\n", filename);
+    return -1;
+  }
+  if (n_threads > 1 && radio_setConcurrent(radio, TRUE) == ERROR) {
+    fprintf(stderr, "Error: could not make the radio concurrent\n");
+    if (b.pairs != stdin) fclose(b.pairs);
+    return -1;
+  }
+
+  b.radio = radio;
+  b.answered = 0;
+  b.failed = 0;
+  pthread_mutex_init(&b.in_mutex, NULL);
+  pthread_mutex_init(&b.out_mutex, NULL);
+
+  if (n_threads <= 1) {
+    batchWorker(&b);
+  } else {
+    for (i = 0; i < n_threads; i++) {
+      if (pthread_create(&threads[i], NULL, batchWorker, &b) != 0) break;
+      started++;
+    }
+    /* If no thread could start, the main thread answers all the pairs */
+    if (started == 0) batchWorker(&b);
+    for (i = 0; i < started; i++) pthread_join(threads[i], NULL);
+  }
+
+  fprintf(stderr, "Answered %ld pairs, %ld failed\n", b.answered, b.failed);
+
+  pthread_mutex_destroy(&b.in_mutex);
+  pthread_mutex_destroy(&b.out_mutex);
+  if (b.pairs != stdin) fclose(b.pairs);
+
+  return (b.failed > 0) ? (int)b.failed : 0;
+}
 
 int main(int argc, char **argv) {
   FILE *fin = NULL;
   Radio *radio = NULL;
   long from_id;
   long to_id;
+  Bool batch;
+  int n_threads = 1, failed;
 
-  if (argc != 4) {
+  batch = (argc >= 4 && strcmp(argv[2], "-b") == 0) ? TRUE : FALSE;
+  if ((batch == FALSE && argc != 4) || (batch == TRUE && argc > 5)) {
     fprintf(stderr, "Usage: %s <radio_file> <from_id> <to_id>\n", argv[0]);
+    fprintf(stderr, "       %s <radio_file> -b <pairs_file|-> [n_threads]\n", argv[0]);
     return EXIT_FAILURE;
   }
+  if (batch == TRUE && argc == 5) {
+    n_threads = atoi(argv[4]);
+    if (n_threads < 1 || n_threads > BATCH_MAX_THREADS) {
+      fprintf(stderr, "Error: the number of threads must be between 1 and %d\n",
+              BATCH_MAX_THREADS);
+      return EXIT_FAILURE;
+    }
+  }
 
   fin = fopen(argv[1], "r");
   if (!fin) {
@@ -36,6 +180,12 @@ int main(int argc, char **argv) {
 
   fclose(fin);
 
+  if (batch == TRUE) {
+    failed = runBatch(radio, argv[3], n_threads);
+    radio_free(radio);
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   from_id = atol(argv[2]);
   to_id = atol(argv[3]);
 
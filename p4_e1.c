@@ -4,9 +4,13 @@
 #include <time.h>
 
 #include "bstree.h"
+#include "perf.h"
 #include "radio.h"
 #include "types.h"
 
+/* A batch of timed removals takes out at most 1/REMOVE_BATCH of the music */
+#define REMOVE_BATCH 16
+
 int mainCleanUp (int ret_value, Radio *r, FILE *pf, Music **songs) {
   if (songs) {
     free(songs);
@@ -163,6 +167,142 @@ int qsort_fun(const void *e1, const void *e2){
 }
 
 
+/* Monotonic clock in nanoseconds; clock() ticks are too coarse for one operation */
+long long nowNanos(void) {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+int cmpLongLong(const void *e1, const void *e2) {
+  long long a = *(const long long *)e1, b = *(const long long *)e2;
+
+  return (a > b) - (a < b);
+}
+
+void printLatency(FILE *f, const char *tree, const char *op, long long *lat, int n) {
+  qsort(lat, n, sizeof(long long), cmpLongLong);
+
+  fprintf(f, "%-11s %-9s %9lld %9lld %9lld %9lld\n", tree, op, lat[n / 2], lat[(n * 9) / 10],
+          lat[(n * 99) / 100], lat[n - 1]);
+}
+
+/*
+ * Repeats every operation over the same random keys. Removals take distinct
+ * keys in batches, and the tree is built again from data with load between
+ * batches: putting the keys back would add them as leaves and change the
+ * shape being measured.
+ */
+Status measureTree(FILE *f, const char *name, BSTree **t, BSTree *(*load)(Music **, int),
+                   Music **data, Music **songs, int n, int repeats, long long *lat) {
+  unsigned int seed;
+  long long start;
+  Music *m;
+  int *order;
+  int i, j, k, batch;
+
+  seed = 1;
+  for (i = 0; i < repeats; i++) {
+    m = songs[rand_r(&seed) % n];
+    start = nowNanos();
+    if (tree_contains(*t, m) == FALSE) return ERROR;
+    lat[i] = nowNanos() - start;
+  }
+  printLatency(f, name, "contains", lat, repeats);
+
+  for (i = 0; i < repeats; i++) {
+    start = nowNanos();
+    if (!tree_find_min(*t)) return ERROR;
+    lat[i] = nowNanos() - start;
+  }
+  printLatency(f, name, "find_min", lat, repeats);
+
+  for (i = 0; i < repeats; i++) {
+    start = nowNanos();
+    if (!tree_find_max(*t)) return ERROR;
+    lat[i] = nowNanos() - start;
+  }
+  printLatency(f, name, "find_max", lat, repeats);
+
+  order = (int *)malloc(sizeof(int) * n);
+  if (!order) return ERROR;
+
+  seed = 1;
+  for (i = 0; i < n; i++) order[i] = i;
+  for (i = n - 1; i > 0; i--) {
+    j = rand_r(&seed) % (i + 1);
+    k = order[i];
+    order[i] = order[j];
+    order[j] = k;
+  }
+
+  /* Consecutive positions of order are distinct keys while a batch is not longer than n */
+  batch = (n >= REMOVE_BATCH) ? n / REMOVE_BATCH : 1;
+  for (i = 0; i < repeats; i++) {
+    if (i > 0 && i % batch == 0) {
+      tree_destroy(*t);
+      *t = load(data, n);
+      if (!*t) break;
+    }
+    m = songs[order[i % n]];
+    start = nowNanos();
+    if (tree_remove(*t, m) == ERROR) break;
+    lat[i] = nowNanos() - start;
+  }
+  free(order);
+  if (i < repeats) return ERROR;
+  printLatency(f, name, "remove", lat, repeats);
+
+  return OK;
+}
+
+/* Builds both trees from the music in file order and compares their latencies */
+Status compareTrees(FILE *f, const Radio *r, int repeats) {
+  BSTree *unbalanced = NULL, *balanced = NULL;
+  Music **songs = NULL, **sorted = NULL;
+  long long *lat = NULL, start, unbalanced_ns = 0, balanced_ns = 0;
+  int n = 0;
+  Status st = ERROR;
+
+  songs = copySongsFromRadio(r, &n);
+  sorted = copySongsFromRadio(r, &n);
+  lat = (long long *)malloc(sizeof(long long) * repeats);
+  if (songs && sorted && lat) {
+    qsort(sorted, n, sizeof(Music *), qsort_fun);
+
+    start = nowNanos();
+    unbalanced = loadUnbalancedTree(songs, n);
+    unbalanced_ns = nowNanos() - start;
+
+    start = nowNanos();
+    balanced = loadBalancedTree(sorted, n);
+    balanced_ns = nowNanos() - start;
+  }
+
+  if (unbalanced && balanced) {
+    fprintf(f, "Build: unbalanced %lld ns (depth %d), balanced %lld ns (depth %d)\n",
+            unbalanced_ns, tree_depth(unbalanced), balanced_ns, tree_depth(balanced));
+    fprintf(f, "Latency over %d random keys (ns):\n", repeats);
+    fprintf(f, "%-11s %-9s %9s %9s %9s %9s\n", "tree", "operation", "p50", "p90", "p99", "max");
+    st = measureTree(f, "unbalanced", &unbalanced, loadUnbalancedTree, songs, songs, n,
+                     repeats, lat);
+    if (st == OK) {
+      st = measureTree(f, "balanced", &balanced, loadBalancedTree, sorted, songs, n, repeats,
+                       lat);
+    }
+  }
+
+  tree_destroy(unbalanced);
+  tree_destroy(balanced);
+  free(songs);
+  free(sorted);
+  free(lat);
+
+  return st;
+}
+
 int main(int argc, char const *argv[]) {
 	FILE *f_in = NULL, *f_out = NULL;
 	BSTree *t = NULL;
@@ -170,14 +310,23 @@ int main(int argc, char const *argv[]) {
 	const char *mode;
 	int n = 0;
 	long	music_id;
-	clock_t elapsed;
+	long long elapsed;
+	int repeats = 0;
 	Radio *r = NULL;
 
-	if (argc != 4) {
-		printf("Usage: %s music_file music_id mode[normal|sorted]\n", argv[0]);
+	if (argc != 4 && argc != 5) {
+		printf("Usage: %s music_file music_id mode[normal|sorted] [repeats]\n", argv[0]);
 		exit(EXIT_FAILURE);
 	}
 
+	if (argc == 5) {
+		repeats = atoi(argv[4]);
+		if (repeats <= 0) {
+			printf("Incorrect number of repeats: %s\n", argv[4]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	mode = argv[3];
 	if (strcmp(mode, "normal") && strcmp(mode, "sorted")) {
 		printf("Incorrect mode: %s\n", mode);
@@ -214,57 +363,67 @@ int main(int argc, char const *argv[]) {
 
 	if (!strcmp(mode, "normal")) {
 		fprintf(f_out, "Mode: normal\n");
-		elapsed = clock();
+		elapsed = nowNanos();
+		perf_begin(PERF_TREE_BUILD);
 		t = loadUnbalancedTree(songs, n);
-		elapsed = clock() - elapsed;
+		perf_end(PERF_TREE_BUILD);
+		elapsed = nowNanos() - elapsed;
 	}
 	else {
 		qsort(songs, n, sizeof(Music *), qsort_fun);
 		fprintf(f_out, "Mode: sorted\n");
-		elapsed = clock();
+		elapsed = nowNanos();
+		perf_begin(PERF_TREE_BUILD);
 		t = loadBalancedTree(songs, n);
-		elapsed = clock() - elapsed;
+		perf_end(PERF_TREE_BUILD);
+		elapsed = nowNanos() - elapsed;
 	}
 
   if (!t) {
     mainCleanUp (EXIT_FAILURE, r, f_in, songs);
   }
 
-  fprintf(f_out, "Tree building time: %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+  fprintf(f_out, "Tree building time: %lld ns (%f seconds)\n", elapsed, elapsed / 1e9);
   fprintf(f_out, "Tree size: %lu\nTree depth: %d\n", (unsigned long)tree_size(t), tree_depth(t));
 
   fprintf(f_out, "Min element in tree: ");
-  elapsed = clock();
+  elapsed = nowNanos();
   music_plain_print(f_out, tree_find_min(t));
-  elapsed = clock() - elapsed;
-  fprintf(f_out, " - %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+  elapsed = nowNanos() - elapsed;
+  fprintf(f_out, " - %lld ns\n", elapsed);
 
   fprintf(f_out, "Max element in tree: ");
-  elapsed = clock();
+  elapsed = nowNanos();
   music_plain_print(f_out, tree_find_max(t));
-  elapsed = clock() - elapsed;
-  fprintf(f_out, " - %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+  elapsed = nowNanos() - elapsed;
+  fprintf(f_out, " - %lld ns\n", elapsed);
 
-  elapsed = clock();
+  elapsed = nowNanos();
   if (tree_contains(t, m) == TRUE) {
     fprintf(f_out, "Element found");
-    elapsed = clock() - elapsed;
-    fprintf(f_out, " - %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+    elapsed = nowNanos() - elapsed;
+    fprintf(f_out, " - %lld ns\n", elapsed);
 
     fprintf(f_out, "Removing element in tree: ");
-    elapsed = clock();
+    elapsed = nowNanos();
     fprintf(f_out, "%s", tree_remove(t, m) == OK ? "OK" : "ERR");
-    elapsed = clock() - elapsed;
-    fprintf(f_out, " - %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+    elapsed = nowNanos() - elapsed;
+    fprintf(f_out, " - %lld ns\n", elapsed);
     fprintf(f_out, "Tree size: %lu\nTree depth: %d\n", (unsigned long)tree_size(t), tree_depth(t));
 
   } else {
     fprintf(f_out, "Element NOT found");
-    elapsed = clock() - elapsed;
-    fprintf(f_out, " - %ld ticks (%f seconds)\n", (long)elapsed, ((float) elapsed) / CLOCKS_PER_SEC);
+    elapsed = nowNanos() - elapsed;
+    fprintf(f_out, " - %lld ns\n", elapsed);
   }
   
   tree_destroy(t);
+
+  if (repeats > 0 && compareTrees(f_out, r, repeats) == ERROR) {
+    fprintf(f_out, "Error measuring the trees\n");
+    mainCleanUp (EXIT_FAILURE, r, f_in, songs);
+  }
+
   mainCleanUp (EXIT_SUCCESS, r, f_in, songs);
 
   return EXIT_SUCCESS;
@@ -0,0 +1,237 @@
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "perf.h"
+
+#define PERF_COUNTERS 4
+
+/* Values of one read of a group */
+typedef struct _PerfSample {
+  unsigned long long count[PERF_COUNTERS];
+  unsigned long long enabled;   /* Time the group was enabled */
+  unsigned long long running;   /* Time the group was counting (less if multiplexed) */
+  double seconds;
+} PerfSample;
+
+/* Counters of one thread; slot[k] is the place of counter k in the group, or -1 */
+typedef struct _PerfThread {
+  int leader;                   /* First counter opened, -1 if none */
+  int fd[PERF_COUNTERS];
+  int slot[PERF_COUNTERS];
+  int n_open;
+  PerfSample start[PERF_REGIONS];
+} PerfThread;
+
+typedef struct _PerfTotals {
+  long calls;
+  double seconds;
+  double count[PERF_COUNTERS];
+} PerfTotals;
+
+static const char *perf_names[PERF_REGIONS] = {"radio_load", "depth_search", "breadth_search",
+                                               "tree_build", "range_search"};
+static const unsigned long long perf_configs[PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+static int perf_enabled = 0;
+static int perf_available[PERF_COUNTERS];   /* Some thread could open the counter */
+static PerfTotals perf_totals[PERF_REGIONS];
+static pthread_mutex_t perf_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t perf_once = PTHREAD_ONCE_INIT;
+static pthread_key_t perf_key;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static void perf_init(void);
+static void perf_dump(void);
+static void perf_closeThread(void *arg);
+static int perf_open(unsigned long long config, int group);
+static PerfThread *perf_getThread(void);
+static void perf_read(const PerfThread *t, PerfSample *s);
+
+static void perf_init(void) {
+  const char *env = getenv("RADIO_PERF");
+
+  if (!env || env[0] == '\0' || strcmp(env, "0") == 0) return;
+  if (pthread_key_create(&perf_key, perf_closeThread) != 0) return;
+
+  perf_enabled = 1;
+  atexit(perf_dump);
+}
+
+static void perf_dump(void) {
+  perf_print(stderr);
+}
+
+static void perf_closeThread(void *arg) {
+  PerfThread *t = (PerfThread *)arg;
+  int k;
+
+  if (!t) return;
+
+  for (k = 0; k < PERF_COUNTERS; k++) {
+    if (t->fd[k] >= 0) close(t->fd[k]);
+  }
+  free(t);
+}
+
+/* User-space count of the calling thread, on any cpu */
+static int perf_open(unsigned long long config, int group) {
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = (group < 0) ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static PerfThread *perf_getThread(void) {
+  PerfThread *t;
+  int k;
+
+  t = (PerfThread *)pthread_getspecific(perf_key);
+  if (t) return t;
+
+  t = (PerfThread *)calloc(1, sizeof(PerfThread));
+  if (!t) return NULL;
+
+  /* The first counter that opens leads the group; the others join it */
+  t->leader = -1;
+  for (k = 0; k < PERF_COUNTERS; k++) {
+    t->fd[k] = perf_open(perf_configs[k], t->leader);
+    t->slot[k] = -1;
+    if (t->fd[k] < 0) continue;
+    if (t->leader < 0) t->leader = t->fd[k];
+    t->slot[k] = t->n_open++;
+  }
+  if (t->leader >= 0) ioctl(t->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+  pthread_mutex_lock(&perf_mutex);
+  for (k = 0; k < PERF_COUNTERS; k++) {
+    if (t->slot[k] >= 0) perf_available[k] = 1;
+  }
+  pthread_mutex_unlock(&perf_mutex);
+
+  if (pthread_setspecific(perf_key, t) != 0) {
+    perf_closeThread(t);
+    return NULL;
+  }
+
+  return t;
+}
+
+static void perf_read(const PerfThread *t, PerfSample *s) {
+  unsigned long long buffer[3 + PERF_COUNTERS];
+  struct timespec now;
+  int k;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  memset(s, 0, sizeof(PerfSample));
+  s->seconds = now.tv_sec + now.tv_nsec * 1e-9;
+
+  /* Format of a group read: number of counters, enabled, running, values */
+  if (t->leader < 0) return;
+  if (read(t->leader, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(buffer[0]))) return;
+
+  s->enabled = buffer[1];
+  s->running = buffer[2];
+  for (k = 0; k < PERF_COUNTERS; k++) {
+    if (t->slot[k] >= 0 && (unsigned long long)t->slot[k] < buffer[0]) {
+      s->count[k] = buffer[3 + t->slot[k]];
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------------------*/
+void perf_begin(PerfRegion region) {
+  PerfThread *t;
+
+  pthread_once(&perf_once, perf_init);
+  if (!perf_enabled || region < 0 || region >= PERF_REGIONS) return;
+
+  t = perf_getThread();
+  if (t) perf_read(t, &t->start[region]);
+}
+
+void perf_end(PerfRegion region) {
+  PerfThread *t;
+  PerfSample end;
+  double scale = 1;
+  int k;
+
+  pthread_once(&perf_once, perf_init);
+  if (!perf_enabled || region < 0 || region >= PERF_REGIONS) return;
+
+  t = perf_getThread();
+  if (!t) return;
+  perf_read(t, &end);
+
+  /* If the counters were multiplexed, extrapolate to the whole time */
+  if (end.running > t->start[region].running) {
+    scale = (double)(end.enabled - t->start[region].enabled) /
+            (end.running - t->start[region].running);
+  }
+
+  pthread_mutex_lock(&perf_mutex);
+  perf_totals[region].calls++;
+  perf_totals[region].seconds += end.seconds - t->start[region].seconds;
+  for (k = 0; k < PERF_COUNTERS; k++) {
+    perf_totals[region].count[k] += scale * (end.count[k] - t->start[region].count[k]);
+  }
+  pthread_mutex_unlock(&perf_mutex);
+}
+
+int perf_print(FILE *pf) {
+  const char *missing = "-";
+  char field[PERF_COUNTERS][32], ipc[32];
+  PerfTotals *p;
+  int i, k, n, total;
+
+  if (!pf || !perf_enabled) return -1;
+
+  total = fprintf(pf, "%-15s %8s %12s %15s %15s %6s %13s %13s\n", "perf", "calls", "time_us",
+                  "cycles", "instructions", "ipc", "cache_misses", "branch_misses");
+  if (total < 0) return -1;
+
+  pthread_mutex_lock(&perf_mutex);
+  for (i = 0; i < PERF_REGIONS; i++) {
+    p = &perf_totals[i];
+    if (p->calls == 0) continue;
+
+    for (k = 0; k < PERF_COUNTERS; k++) {
+      if (perf_available[k]) {
+        sprintf(field[k], "%.0f", p->count[k]);
+      } else {
+        strcpy(field[k], missing);
+      }
+    }
+    if (perf_available[0] && perf_available[1] && p->count[0] > 0) {
+      sprintf(ipc, "%.2f", p->count[1] / p->count[0]);
+    } else {
+      strcpy(ipc, missing);
+    }
+    n = fprintf(pf, "%-15s %8ld %12.1f %15s %15s %6s %13s %13s\n", perf_names[i], p->calls,
+                p->seconds * 1e6, field[0], field[1], ipc, field[2], field[3]);
+    if (n < 0) break;
+    total += n;
+  }
+  pthread_mutex_unlock(&perf_mutex);
+
+  return (i < PERF_REGIONS) ? -1 : total;
+}
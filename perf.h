@@ -0,0 +1,64 @@
+/**
+ * @file perf.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Hardware performance counters around named regions
+ *
+ * @details When the environment variable RADIO_PERF is set (to anything
+ * but "0") every thread that enters a region opens, through Linux
+ * perf_event_open, a group of counters for cycles, instructions, cache
+ * misses and branch misses of its own user-space code. perf_begin and
+ * perf_end read the group, and the difference is added to the region.
+ * Different regions can be nested, and any region can be measured from
+ * several threads at once.
+ *
+ * The calls, wall time and counters of every region are printed to stderr
+ * when the program exits. If the counters cannot be opened (no PMU, or
+ * /proc/sys/kernel/perf_event_paranoid too high) only calls and time are
+ * reported. Without RADIO_PERF the regions cost one check each.
+ */
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdio.h>
+
+/**
+ * @brief Measured regions.
+ */
+typedef enum {
+  PERF_RADIO_LOAD,     /*!< radio_readFromFile */
+  PERF_DEPTH_SEARCH,   /*!< Traversal of radio_depthSearch and radio_printDepthSearch */
+  PERF_BREADTH_SEARCH, /*!< Traversal of radio_breadthSearch and radio_printBreadthSearch */
+  PERF_TREE_BUILD,     /*!< Building a BSTree in the drivers */
+  PERF_RANGE_SEARCH,   /*!< tree_rangeSearch */
+  PERF_REGIONS         /*!< Number of regions */
+} PerfRegion;
+
+/**
+ * @brief Starts measuring a region in the calling thread.
+ *
+ * @param region Region.
+ */
+void perf_begin(PerfRegion region);
+
+/**
+ * @brief Stops measuring a region in the calling thread and adds what
+ * was measured since the matching perf_begin.
+ *
+ * @param region Region.
+ */
+void perf_end(PerfRegion region);
+
+/**
+ * @brief Prints the regions that were entered, one per line.
+ *
+ * @param pf File descriptor.
+ *
+ * @return The number of characters printed, or -1 if there is any error
+ * or RADIO_PERF is not set.
+ */
+int perf_print(FILE *pf);
+
+#endif /* PERF_H */
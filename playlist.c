@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "playlist.h"
+
+#define PLAYLIST_INIT_MEMO 1024   /* Power of 2 */
+#define PLAYLIST_INIT_STACK 64
+
+/* Pending music of playlist_relaxed */
+typedef struct _RelaxFrame {
+  int v;
+  int rem;
+  int k;        /* Next relation to try */
+  int best;     /* Best fill found so far */
+} RelaxFrame;
+
+typedef struct _Search {
+  const Radio *r;
+  int n;              /* Number of music */
+  int *offsets;       /* CSR offsets of the relations */
+  int *targets;       /* Destinations, by decreasing duration inside each music */
+  int *duration;      /* Duration of every music */
+  unsigned long long *memo_keys;   /* Music and remaining budget of every entry */
+  int *memo_values;   /* Best fill allowing repetitions, -1 in free entries */
+  int memo_capacity;
+  int memo_size;
+  RelaxFrame *stack;  /* Work stack of playlist_relaxed */
+  int stack_capacity;
+  int budget;
+  Bool *visited;      /* Music in the current path */
+  int *path;          /* Positions of the current path */
+  int depth;          /* Number of music in the current path */
+  Playlist *best;     /* Playlists found, by decreasing total */
+  int k;
+  int found;          /* Number of playlists in best */
+  int bound;          /* Upper bound of any playlist total */
+  long steps;
+  Bool stopped;       /* PLAYLIST_MAX_STEPS reached */
+  Status status;
+} Search;
+
+typedef struct _SortEntry {
+  int duration;
+  int slot;
+} SortEntry;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static Status playlist_prepare(Search *s);
+static void playlist_release(Search *s);
+static int playlist_entryCmp(const void *e1, const void *e2);
+static int playlist_firstFitting(const Search *s, int v, int rem);
+static unsigned long long playlist_memoKey(int v, int rem);
+static int playlist_memoSlot(const Search *s, unsigned long long key);
+static int playlist_memoGet(const Search *s, int v, int rem);
+static Status playlist_memoPut(Search *s, int v, int rem, int value);
+static Status playlist_relaxPush(Search *s, int *top, int v, int rem);
+static int playlist_relaxed(Search *s, int v, int rem);
+static int playlist_threshold(const Search *s);
+static void playlist_record(Search *s, int total);
+static void playlist_dfs(Search *s, int v, int rem, int total);
+
+static int playlist_entryCmp(const void *e1, const void *e2) {
+  const SortEntry *a = (const SortEntry *)e1;
+  const SortEntry *b = (const SortEntry *)e2;
+
+  if (a->duration != b->duration) return b->duration - a->duration;
+
+  return a->slot - b->slot;
+}
+
+static Status playlist_prepare(Search *s) {
+  SortEntry *entries;
+  int i, k, d, max_d = 1;
+
+  if (radio_getAdjacency(s->r, &s->n, &s->offsets, &s->targets) == ERROR) return ERROR;
+  if (s->n <= 0) return ERROR;
+
+  s->duration = (int *)malloc(sizeof(int) * s->n);
+  s->memo_keys = (unsigned long long *)malloc(sizeof(unsigned long long) * PLAYLIST_INIT_MEMO);
+  s->memo_values = (int *)malloc(sizeof(int) * PLAYLIST_INIT_MEMO);
+  s->stack = (RelaxFrame *)malloc(sizeof(RelaxFrame) * PLAYLIST_INIT_STACK);
+  s->visited = (Bool *)calloc(s->n, sizeof(Bool));
+  s->path = (int *)malloc(sizeof(int) * s->n);
+  if (!s->duration || !s->memo_keys || !s->memo_values || !s->stack || !s->visited ||
+      !s->path) {
+    return ERROR;
+  }
+  s->memo_capacity = PLAYLIST_INIT_MEMO;
+  memset(s->memo_values, 0xFF, sizeof(int) * PLAYLIST_INIT_MEMO);
+  s->stack_capacity = PLAYLIST_INIT_STACK;
+
+  for (i = 0; i < s->n; i++) {
+    s->duration[i] = radio_getDurationAt(s->r, i);
+    d = s->offsets[i + 1] - s->offsets[i];
+    if (d > max_d) max_d = d;
+  }
+
+  entries = (SortEntry *)malloc(sizeof(SortEntry) * max_d);
+  if (!entries) return ERROR;
+
+  for (i = 0; i < s->n; i++) {
+    d = s->offsets[i + 1] - s->offsets[i];
+    for (k = 0; k < d; k++) {
+      entries[k].slot = s->targets[s->offsets[i] + k];
+      entries[k].duration = s->duration[entries[k].slot];
+    }
+    qsort(entries, d, sizeof(SortEntry), playlist_entryCmp);
+    for (k = 0; k < d; k++) {
+      s->targets[s->offsets[i] + k] = entries[k].slot;
+    }
+  }
+
+  free(entries);
+  return OK;
+}
+
+static void playlist_release(Search *s) {
+  free(s->offsets);
+  free(s->targets);
+  free(s->duration);
+  free(s->memo_keys);
+  free(s->memo_values);
+  free(s->stack);
+  free(s->visited);
+  free(s->path);
+}
+
+/* First relation of v whose destination fits in rem (they are sorted by decreasing duration) */
+static int playlist_firstFitting(const Search *s, int v, int rem) {
+  int low = s->offsets[v], high = s->offsets[v + 1], mid;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (s->duration[s->targets[mid]] > rem) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+static unsigned long long playlist_memoKey(int v, int rem) {
+  return ((unsigned long long)(unsigned int)v << 32) | (unsigned int)rem;
+}
+
+/* Entry of the key, or the free entry where it would go (the table is never full) */
+static int playlist_memoSlot(const Search *s, unsigned long long key) {
+  int h = (int)(((key * 0x9E3779B97F4A7C15ULL) >> 32) & (s->memo_capacity - 1));
+
+  while (s->memo_values[h] >= 0 && s->memo_keys[h] != key) h = (h + 1) & (s->memo_capacity - 1);
+
+  return h;
+}
+
+/* Best fill of rem seconds after v, or -1 if it has not been computed */
+static int playlist_memoGet(const Search *s, int v, int rem) {
+  return s->memo_values[playlist_memoSlot(s, playlist_memoKey(v, rem))];
+}
+
+/*
+ * Only the (music, remaining budget) pairs that the search reaches are
+ * stored, at most one per step, instead of a row of budget + 1 values
+ * for every music.
+ */
+static Status playlist_memoPut(Search *s, int v, int rem, int value) {
+  unsigned long long *keys = s->memo_keys;
+  int *values = s->memo_values;
+  int capacity = s->memo_capacity, i, h;
+
+  /* The table is kept at most half full */
+  if (2 * (s->memo_size + 1) > capacity) {
+    s->memo_keys = (unsigned long long *)malloc(sizeof(unsigned long long) * capacity * 2);
+    s->memo_values = (int *)malloc(sizeof(int) * capacity * 2);
+    if (!s->memo_keys || !s->memo_values) {
+      free(s->memo_keys);
+      free(s->memo_values);
+      s->memo_keys = keys;
+      s->memo_values = values;
+      return ERROR;
+    }
+    memset(s->memo_values, 0xFF, sizeof(int) * capacity * 2);
+    s->memo_capacity = capacity * 2;
+    for (i = 0; i < capacity; i++) {
+      if (values[i] < 0) continue;
+      h = playlist_memoSlot(s, keys[i]);
+      s->memo_keys[h] = keys[i];
+      s->memo_values[h] = values[i];
+    }
+    free(keys);
+    free(values);
+  }
+
+  h = playlist_memoSlot(s, playlist_memoKey(v, rem));
+  if (s->memo_values[h] < 0) s->memo_size++;
+  s->memo_keys[h] = playlist_memoKey(v, rem);
+  s->memo_values[h] = value;
+
+  return OK;
+}
+
+/* Starts the fill of rem seconds after v on the work stack; counts as a step */
+static Status playlist_relaxPush(Search *s, int *top, int v, int rem) {
+  RelaxFrame *stack;
+
+  if (++s->steps > PLAYLIST_MAX_STEPS) {
+    s->stopped = TRUE;
+    return ERROR;
+  }
+
+  if (*top == s->stack_capacity) {
+    stack = (RelaxFrame *)realloc(s->stack, sizeof(RelaxFrame) * s->stack_capacity * 2);
+    if (!stack) {
+      s->status = ERROR;
+      return ERROR;
+    }
+    s->stack = stack;
+    s->stack_capacity *= 2;
+  }
+
+  s->stack[*top].v = v;
+  s->stack[*top].rem = rem;
+  s->stack[*top].k = playlist_firstFitting(s, v, rem);
+  s->stack[*top].best = 0;
+  (*top)++;
+
+  return OK;
+}
+
+/*
+ * Best fill of rem seconds after v when music may repeat. It never
+ * underestimates the fill without repetitions, so it is a valid bound.
+ * Chains of short music can be as long as the budget, so the recursion
+ * runs on a stack of its own.
+ */
+static int playlist_relaxed(Search *s, int v, int rem) {
+  RelaxFrame *f;
+  int top = 0, u, d, value;
+
+  if (s->status == ERROR || s->stopped == TRUE) return rem;
+
+  value = playlist_memoGet(s, v, rem);
+  if (value >= 0) return value;
+
+  if (playlist_relaxPush(s, &top, v, rem) == ERROR) return rem;
+
+  while (top > 0) {
+    f = &s->stack[top - 1];
+
+    if (f->k < s->offsets[f->v + 1] && f->best < f->rem && s->duration[s->targets[f->k]] > 0) {
+      u = s->targets[f->k];
+      d = s->duration[u];
+      value = playlist_memoGet(s, u, f->rem - d);
+      if (value < 0) {
+        /* The relation is tried again when the fill of u is known */
+        if (playlist_relaxPush(s, &top, u, f->rem - d) == ERROR) return rem;
+        continue;
+      }
+      if (d + value > f->best) f->best = d + value;
+      f->k++;
+      continue;
+    }
+
+    if (playlist_memoPut(s, f->v, f->rem, f->best) == ERROR) {
+      s->status = ERROR;
+      return rem;
+    }
+    top--;
+  }
+
+  return playlist_memoGet(s, v, rem);
+}
+
+static int playlist_threshold(const Search *s) {
+  return (s->found < s->k) ? -1 : s->best[s->k - 1].total;
+}
+
+static void playlist_record(Search *s, int total) {
+  long *ids;
+  int i, pos;
+
+  if (total <= playlist_threshold(s)) return;
+
+  ids = (long *)malloc(sizeof(long) * s->depth);
+  if (!ids) {
+    s->status = ERROR;
+    return;
+  }
+  for (i = 0; i < s->depth; i++) {
+    ids[i] = radio_getIdAt(s->r, s->path[i]);
+  }
+
+  if (s->found == s->k) {
+    free(s->best[s->k - 1].ids);
+    s->found--;
+  }
+
+  pos = s->found;
+  while (pos > 0 && s->best[pos - 1].total < total) {
+    s->best[pos] = s->best[pos - 1];
+    pos--;
+  }
+
+  s->best[pos].ids = ids;
+  s->best[pos].n = s->depth;
+  s->best[pos].total = total;
+  s->found++;
+}
+
+static void playlist_dfs(Search *s, int v, int rem, int total) {
+  Bool extended = FALSE;
+  int k, u, d;
+
+  if (++s->steps > PLAYLIST_MAX_STEPS) {
+    s->stopped = TRUE;
+    return;
+  }
+
+  for (k = playlist_firstFitting(s, v, rem); k < s->offsets[v + 1]; k++) {
+    u = s->targets[k];
+    d = s->duration[u];
+    if (d == 0) break;
+    if (s->visited[u] == TRUE) continue;
+    if (total + d + playlist_relaxed(s, u, rem - d) <= playlist_threshold(s)) continue;
+
+    extended = TRUE;
+    s->visited[u] = TRUE;
+    s->path[s->depth++] = u;
+    playlist_dfs(s, u, rem - d, total + d);
+    s->depth--;
+    s->visited[u] = FALSE;
+
+    if (s->stopped == TRUE || s->status == ERROR) return;
+    if (playlist_threshold(s) >= s->bound) return;
+  }
+
+  if (extended == FALSE) playlist_record(s, total);
+}
+
+/*----------------------------------------------------------------------------------------*/
+int playlist_search(const Radio *r, long start_id, int budget, int k, Playlist *best,
+                    Bool *exact) {
+  Search s;
+  int start;
+
+  if (!r || !best || budget < 0 || k <= 0) return -1;
+
+  memset(&s, 0, sizeof(Search));
+  s.r = r;
+  s.budget = budget;
+  s.best = best;
+  s.k = k;
+  s.status = OK;
+  s.stopped = FALSE;
+
+  start = _radio_findmusicById(r, start_id);
+  if (start < 0 || playlist_prepare(&s) == ERROR) {
+    playlist_release(&s);
+    return -1;
+  }
+
+  if (s.duration[start] <= budget) {
+    s.bound = s.duration[start] + playlist_relaxed(&s, start, budget - s.duration[start]);
+    s.visited[start] = TRUE;
+    s.path[s.depth++] = start;
+    playlist_dfs(&s, start, budget - s.duration[start], s.duration[start]);
+  }
+
+  playlist_release(&s);
+
+  if (s.status == ERROR) {
+    playlist_free(best, s.found);
+    return -1;
+  }
+
+  if (exact) *exact = s.stopped ? FALSE : TRUE;
+
+  return s.found;
+}
+
+void playlist_free(Playlist *p, int n) {
+  int i;
+
+  if (!p) return;
+
+  for (i = 0; i < n; i++) {
+    free(p[i].ids);
+    p[i].ids = NULL;
+  }
+}
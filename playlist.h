@@ -0,0 +1,78 @@
+/**
+ * @file playlist.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Duration-budgeted playlists over a radio
+ *
+ * @details A playlist is a path of relations starting at a given music,
+ * without repeated music, whose summed durations (music_getDuration) do
+ * not exceed a budget. The search looks for the playlists that get
+ * closest to the budget ("fill the next 30 minutes from this song").
+ *
+ * @see radio.h
+ */
+
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include "radio.h"
+#include "types.h"
+
+/**
+ * @brief Maximum number of search steps before giving up on optimality.
+ */
+#define PLAYLIST_MAX_STEPS 2000000L
+
+/**
+ * @brief A playlist found by playlist_search.
+ */
+typedef struct {
+  long *ids;   /*!< Ids of the music, the first one is the start music */
+  int n;       /*!< Number of music */
+  int total;   /*!< Summed duration of the music, in seconds */
+} Playlist;
+
+/**
+ * @brief Finds the k longest playlists that fit a duration budget.
+ *
+ * Runs a branch-and-bound depth-first search from start_id. The related
+ * music are tried from the longest to the shortest one, skipping the ones
+ * that do not fit in the remaining budget, and a branch is pruned when
+ * even the best fill allowing repeated music cannot beat the k-th
+ * playlist found so far. That fill is memoized in a hash table with the
+ * pairs of music and remaining budget the search reaches, so the memory
+ * does not grow with the budget times the number of music. Music with
+ * duration 0 are never added.
+ *
+ * Only maximal playlists (that cannot be extended within the budget) are
+ * returned, sorted by decreasing total duration. If the search needs more
+ * than PLAYLIST_MAX_STEPS steps it stops and returns the best playlists
+ * found so far.
+ *
+ * This function allocates memory for the ids of every playlist; free them
+ * with playlist_free.
+ *
+ * @param r Pointer to the radio.
+ * @param start_id ID of the first music of the playlists.
+ * @param budget Maximum summed duration, in seconds.
+ * @param k Maximum number of playlists to return, greater than 0.
+ * @param best Output array with k positions.
+ * @param exact Output, TRUE if the search finished and the playlists are
+ * optimal, FALSE if it stopped early (can be NULL).
+ *
+ * @return The number of playlists stored in best, or -1 if there is any
+ * error (0 if the start music alone does not fit the budget).
+ */
+int playlist_search(const Radio *r, long start_id, int budget, int k, Playlist *best,
+                    Bool *exact);
+
+/**
+ * @brief Frees the ids of an array of playlists.
+ *
+ * @param p Array of playlists.
+ * @param n Number of playlists in the array.
+ */
+void playlist_free(Playlist *p, int n);
+
+#endif /* PLAYLIST_H */
@@ -0,0 +1,48 @@
+/**
+ * @file protocol.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Request/response protocol of the radio query server
+ *
+ * @details Clients connect to the Unix domain socket of radio_server and
+ * send one request per line, made of a command and its arguments
+ * separated by spaces:
+ *
+ *   CONTAINS <id>                          1 if the music exists, 0 otherwise
+ *   DFS <from_id> <to_id>                  music visited by a depth-first search
+ *   BFS <from_id> <to_id>                  music visited by a breadth-first search
+ *   PATH <from_id> <to_id> [relation|duration]
+ *                                          music of the cheapest path and its cost
+ *   RANGE <min_duration> <max_duration>    music whose duration is in the range
+ *   STATS                                  memory and degree statistics
+ *   QUIT                                   closes the connection
+ *
+ * The answer to every request is zero or more data lines followed by a
+ * final line, which is either PROTOCOL_OK or PROTOCOL_ERR, a space and an
+ * error message. Data lines never start with any of them. A request longer
+ * than PROTOCOL_LINE_SIZE is discarded up to its end and answered with a
+ * single PROTOCOL_ERR line.
+ *
+ * @see radio.h
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+/**
+ * @brief Maximum length of a request or response line.
+ */
+#define PROTOCOL_LINE_SIZE 4096
+
+/**
+ * @brief Final line of a successful answer.
+ */
+#define PROTOCOL_OK "OK"
+
+/**
+ * @brief Start of the final line of a failed answer.
+ */
+#define PROTOCOL_ERR "ERR"
+
+#endif /* PROTOCOL_H */
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
 #include "queue.h"
 
 #define MAX_QUEUE 4096
@@ -42,7 +43,7 @@ Queue *queue_new() {
   Queue *q;
   int i;
 
-  q = (Queue *)malloc(sizeof(Queue));
+  q = (Queue *)alloc_malloc(ALLOC_QUEUE, sizeof(Queue));
   if (!q) return NULL;
 
   for (i = 0; i < MAX_QUEUE; i++) {
@@ -58,7 +59,7 @@ Queue *queue_new() {
 void queue_free(Queue *q) {
   if (!q) return;
 
-  free(q);
+  alloc_free(q);
 }
 
 Bool queue_isEmpty(const Queue *q) {
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
 #include "list.h"
 #include "queue.h"
 
@@ -11,12 +12,12 @@ struct _Queue {
 Queue *queue_new() {
   Queue *q;
 
-  q = (Queue *)malloc(sizeof(Queue));
+  q = (Queue *)alloc_malloc(ALLOC_QUEUE, sizeof(Queue));
   if (!q) return NULL;
 
   q->pl = list_new();
   if (!q->pl) {
-    free(q);
+    alloc_free(q);
     return NULL;
   }
 
@@ -27,7 +28,7 @@ void queue_free(Queue *q) {
   if (!q) return;
 
   list_free(q->pl);
-  free(q);
+  alloc_free(q);
 }
 
 Bool queue_isEmpty(const Queue *q) {
@@ -1,52 +1,732 @@
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "heap.h"
+#include "intersect.h"
+#include "perf.h"
 #include "queue.h"
 #include "radio.h"
 #include "stack.h"
+#include "trace.h"
 
 #define MAX_MSC 4096
 #define RADIO_LINE_SIZE 4096
+#define INIT_RELATIONS 4
+#define FCT_RELATIONS 2
+#define RADIO_ID_TABLE (2 * MAX_MSC)
+#define INIT_NAMES 1024
+#define FCT_NAMES 2
+#define RADIO_HOPS_FAR 254    /* Stored for 254 hops or more */
+#define RADIO_HOPS_NONE 255   /* Stored if there is no path */
+
+/* Relations leaving one music, sorted by destination position */
+typedef struct _Relations {
+  int *dest;        /* Positions of the destination music */
+  double *weight;   /* Weight of each relation, NULL while all are RADIO_DEFAULT_WEIGHT */
+  int size;         /* Number of relations */
+  int capacity;     /* Capacity of dest (and weight) */
+} Relations;
 
 struct _Radio {
-  Music *songs[MAX_MSC];               /* Array with the radio music */
-  Bool relations[MAX_MSC][MAX_MSC];    /* Adjacency matrix */
+  Music *songs[MAX_MSC];               /* Handles of the radio music */
+  long ids[MAX_MSC];                   /* Id of every music */
+  unsigned short durations[MAX_MSC];   /* Duration of every music */
+  State states[MAX_MSC];               /* State of every music, mirrored in its handle */
+  size_t titles[MAX_MSC];              /* Offset of every title in names */
+  size_t artists[MAX_MSC];             /* Offset of every artist in names */
+  size_t descs[MAX_MSC];               /* Offset of the description of every music not
+                                          loaded yet (songs[i] == NULL) in names */
+  char *names;                         /* Pool with all the titles and artists */
+  size_t names_size;                   /* Bytes used in names */
+  size_t names_capacity;               /* Capacity of names */
+  int id_table[RADIO_ID_TABLE];        /* Open addressing table of positions, -1 if empty */
+  Relations relations[MAX_MSC];        /* Adjacency lists */
+  Relations incoming[MAX_MSC];         /* Origins of the relations reaching each music */
   int num_music;                       /* Total number of music */
   int num_relations;                   /* Total number of relations */
+  int component_parent[MAX_MSC];       /* Union-find parent of every music */
+  int component_rank[MAX_MSC];         /* Union-find rank of every root */
+  int component_size[MAX_MSC];         /* Number of music of every root */
+  int num_components;                  /* Number of weakly connected components */
+  int landmarks[RADIO_MAX_LANDMARKS];  /* Positions of the landmark music */
+  int num_landmarks;                   /* Number of landmarks, 0 if there are none */
+  unsigned char *hops_from;            /* num_landmarks bytes per music: hops from each
+                                          landmark, saturated at RADIO_HOPS_FAR */
+  unsigned char *hops_to;              /* num_landmarks bytes per music: hops to each landmark */
+  Bool concurrent;                     /* TRUE if the functions take lock */
+  Bool lazy;                           /* TRUE if new music are loaded on first access */
+  pthread_rwlock_t lock;               /* Writers exclusive, readers shared */
 };
 
+/* Visited marks of the searches of one thread in concurrent mode */
+typedef struct _RadioScratch {
+  unsigned int *mark;   /* mark[i] == epoch if music i was visited */
+  int *work;            /* Stack or queue of the positions a search has to expand */
+  unsigned int epoch;   /* Current search */
+  int capacity;         /* Capacity of mark and work */
+} RadioScratch;
+
+static pthread_key_t radio_scratch_key;
+static pthread_once_t radio_scratch_once = PTHREAD_ONCE_INIT;
+static Bool radio_scratch_ready = FALSE;
+
 /*----------------------------------------------------------------------------------------*/
 /*
 Private functions:
 */
+static unsigned int radio_hashId(long id);
 static int radio_getIndexById(const Radio *r, long id);
+static Status radio_addName(Radio *r, const char *name, size_t *offset);
+static Status radio_loadMusic(const Radio *r, int i);
+static Status radio_loadAll(Radio *r);
 static Status radio_resetMusicStates(Radio *r);
+static int radio_findRelation(const Relations *rel, int dest, Bool *found);
+static Status radio_insertRelation(Relations *rel, int pos, int dest, double weight);
+static double radio_transitionCost(const Radio *r, const Relations *rel, int k,
+                                   RadioWeight weight);
+static int radio_findComponent(const Radio *r, int i);
+static void radio_joinComponents(Radio *r, int a, int b);
+static int radio_kahn(const Radio *r, int *order);
+static void radio_dropLandmarks(Radio *r);
+static void radio_landmarkSearch(const Radio *r, int from, Bool backward, unsigned char *hops,
+                                 int *queue, int *dist);
+static Bool radio_landmarkBounds(const Radio *r, int a, int b, int *lower, int *upper);
+static int radio_hopDistance(const Radio *r, int a, int b, int upper);
+static int radio_printVisited(FILE *pf, const Music *m, const RadioScratch *scratch);
+static Status radio_searchUnreachable(FILE *pf, Radio *r, RadioScratch *scratch, int i_from);
+static Status radio_scratchSearch(FILE *pf, Radio *r, RadioScratch *scratch, int i_from,
+                                  int i_to, Bool depth);
+static Status radio_addRelation(Radio *r, int i_orig, int i_dest, int pos, double weight);
+static double radio_similarity(const Radio *r, int a, int b, RadioSimilarity sim, int *common);
+static void radio_readLock(const Radio *r);
+static void radio_writeLock(Radio *r);
+static void radio_unlock(const Radio *r);
+static void radio_scratchCreateKey(void);
+static void radio_scratchFree(void *scratch);
+static RadioScratch *radio_getScratch(int n);
+static Bool radio_visit(Radio *r, RadioScratch *scratch, int i);
+static Status radio_newLazyMusic(Radio *r, char *desc);
+static Status radio_newMusicUnlocked(Radio *r, char *desc);
+static Status radio_newRelationUnlocked(Radio *r, long orig, long dest);
+static Status radio_newWeightedRelationUnlocked(Radio *r, long orig, long dest, double weight);
+static Bool radio_relationExistsUnlocked(const Radio *r, long orig, long dest);
+static double radio_getRelationWeightUnlocked(const Radio *r, long orig, long dest);
+static int radio_getNumberOfRelationsFromIdUnlocked(const Radio *r, long id);
+static long *radio_getRelationsFromIdUnlocked(const Radio *r, long id);
+static Bool radio_sameComponentUnlocked(const Radio *r, long a, long b);
+static int radio_getComponentSizeUnlocked(const Radio *r, long id);
+static long *radio_similarSongsUnlocked(const Radio *r, long id, int k, RadioSimilarity sim,
+                                        double *scores, int *n_similar);
+static Status radio_getWeightedAdjacencyUnlocked(const Radio *r, int *n_music, int **offsets,
+                                                 int **targets, double **weights);
+static int radio_printUnlocked(FILE *pf, const Radio *r);
+static Status radio_readFile(FILE *fin, Radio *r);
+static Status radio_depthSearchUnlocked(FILE *pf, Radio *r, long from_id, long to_id);
+static Status radio_breadthSearchUnlocked(FILE *pf, Radio *r, long from_id, long to_id);
+static long *radio_shortestPathUnlocked(const Radio *r, long from_id, long to_id,
+                                        RadioWeight weight, int *n_path, double *cost);
+static int radio_estimateDistanceUnlocked(const Radio *r, long from_id, long to_id,
+                                          int max_error);
+static Status radio_getStatsUnlocked(const Radio *r, RadioStats *stats);
+
+/* Fibonacci hashing of the id into [0, RADIO_ID_TABLE) */
+static unsigned int radio_hashId(long id) {
+  unsigned long long x = (unsigned long long)id * 0x9E3779B97F4A7C15ULL;
+
+  return (unsigned int)((x >> 32) & (RADIO_ID_TABLE - 1));
+}
 
 static int radio_getIndexById(const Radio *r, long id) {
-  int i;
+  unsigned int h;
 
   if (!r || id < 0) return -1;
 
-  for (i = 0; i < r->num_music; i++) {
-    if (music_getId(r->songs[i]) == id) return i;
+  /* The table is never more than half full, so there is always an empty slot */
+  for (h = radio_hashId(id); r->id_table[h] >= 0; h = (h + 1) & (RADIO_ID_TABLE - 1)) {
+    if (r->ids[r->id_table[h]] == id) return r->id_table[h];
   }
 
   return -1;
 }
 
+/* Copies a title or an artist to the end of the string pool */
+static Status radio_addName(Radio *r, const char *name, size_t *offset) {
+  size_t len = strlen(name) + 1, capacity;
+  char *names;
+
+  if (r->names_size + len > r->names_capacity) {
+    capacity = r->names_capacity > 0 ? r->names_capacity : INIT_NAMES;
+    while (r->names_size + len > capacity) capacity *= FCT_NAMES;
+
+    names = (char *)realloc(r->names, capacity);
+    if (!names) return ERROR;
+    r->names = names;
+    r->names_capacity = capacity;
+  }
+
+  memcpy(r->names + r->names_size, name, len);
+  *offset = r->names_size;
+  r->names_size += len;
+
+  return OK;
+}
+
+/*
+ * Creates the handle of a music added in lazy mode from its description.
+ * The title and the artist overwrite the description, which is longer, so
+ * the pool does not move and the strings already returned stay valid.
+ * Loading does not change what the radio contains, so it can be done on a
+ * const radio; in concurrent mode every music is already loaded.
+ */
+static Status radio_loadMusic(const Radio *r, int i) {
+  Radio *w = (Radio *)r;
+  Music *m;
+  char *desc;
+  size_t title_len, artist_len;
+
+  if (r->songs[i]) return OK;
+
+  desc = w->names + w->descs[i];
+  m = music_initFromString(desc);
+  if (!m) return ERROR;
+  if (music_setIndex(m, i) == ERROR || music_setState(m, r->states[i]) == ERROR) {
+    music_free(m);
+    return ERROR;
+  }
+
+  title_len = strlen(music_getTitle(m)) + 1;
+  artist_len = strlen(music_getArtist(m)) + 1;
+  if (title_len + artist_len <= strlen(desc) + 1) {
+    memcpy(desc, music_getTitle(m), title_len);
+    memcpy(desc + title_len, music_getArtist(m), artist_len);
+    w->titles[i] = w->descs[i];
+    w->artists[i] = w->descs[i] + title_len;
+  } else if (radio_addName(w, music_getTitle(m), &w->titles[i]) == ERROR ||
+             radio_addName(w, music_getArtist(m), &w->artists[i]) == ERROR) {
+    music_free(m);
+    return ERROR;
+  }
+  w->durations[i] = music_getDuration(m);
+  w->songs[i] = m;
+
+  return OK;
+}
+
+static Status radio_loadAll(Radio *r) {
+  int i;
+
+  for (i = 0; i < r->num_music; i++) {
+    if (radio_loadMusic(r, i) == ERROR) return ERROR;
+  }
+
+  return OK;
+}
+
+/* Only the music whose state changed are touched */
 static Status radio_resetMusicStates(Radio *r) {
   int i;
 
   if (!r) return ERROR;
 
   for (i = 0; i < r->num_music; i++) {
-    if (music_setState(r->songs[i], NOT_LISTENED) == ERROR) return ERROR;
+    if (r->states[i] == NOT_LISTENED) continue;
+    if (r->songs[i] && music_setState(r->songs[i], NOT_LISTENED) == ERROR) return ERROR;
+    r->states[i] = NOT_LISTENED;
+  }
+
+  return OK;
+}
+
+/* Binary search of dest; returns its position or where it should be inserted */
+static int radio_findRelation(const Relations *rel, int dest, Bool *found) {
+  int low = 0, high = rel->size, mid;
+
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (rel->dest[mid] < dest) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  *found = (low < rel->size && rel->dest[low] == dest) ? TRUE : FALSE;
+
+  return low;
+}
+
+static Status radio_insertRelation(Relations *rel, int pos, int dest, double weight) {
+  int *tmp_dest;
+  double *tmp_weight;
+  int new_capacity, i;
+
+  if (rel->size == rel->capacity) {
+    new_capacity = rel->capacity ? rel->capacity * FCT_RELATIONS : INIT_RELATIONS;
+    tmp_dest = (int *)realloc(rel->dest, sizeof(int) * new_capacity);
+    if (!tmp_dest) return ERROR;
+    rel->dest = tmp_dest;
+
+    if (rel->weight) {
+      tmp_weight = (double *)realloc(rel->weight, sizeof(double) * new_capacity);
+      if (!tmp_weight) return ERROR;
+      rel->weight = tmp_weight;
+    }
+    rel->capacity = new_capacity;
+  }
+
+  /* The weights are only stored once one relation needs a non default one */
+  if (!rel->weight && weight != RADIO_DEFAULT_WEIGHT) {
+    rel->weight = (double *)malloc(sizeof(double) * rel->capacity);
+    if (!rel->weight) return ERROR;
+    for (i = 0; i < rel->size; i++) rel->weight[i] = RADIO_DEFAULT_WEIGHT;
+  }
+
+  memmove(&rel->dest[pos + 1], &rel->dest[pos], sizeof(int) * (rel->size - pos));
+  rel->dest[pos] = dest;
+  if (rel->weight) {
+    memmove(&rel->weight[pos + 1], &rel->weight[pos], sizeof(double) * (rel->size - pos));
+    rel->weight[pos] = weight;
+  }
+  rel->size++;
+
+  return OK;
+}
+
+/* Cost of the k-th relation of rel, or -1 if its destination cannot be loaded */
+static double radio_transitionCost(const Radio *r, const Relations *rel, int k,
+                                   RadioWeight weight) {
+  if (weight == RADIO_DURATION_WEIGHT) {
+    if (radio_loadMusic(r, rel->dest[k]) == ERROR) return -1;
+    return (double)r->durations[rel->dest[k]];
+  }
+
+  return rel->weight ? rel->weight[k] : RADIO_DEFAULT_WEIGHT;
+}
+
+/*
+ * Root of the component of i. It does not compress the path so that it can
+ * be used on a const radio; union by rank keeps the trees O(log n) high and
+ * radio_joinComponents flattens the paths it walks.
+ */
+static int radio_findComponent(const Radio *r, int i) {
+  while (r->component_parent[i] != i) i = r->component_parent[i];
+
+  return i;
+}
+
+static void radio_joinComponents(Radio *r, int a, int b) {
+  int root_a, root_b, next;
+
+  root_a = radio_findComponent(r, a);
+  root_b = radio_findComponent(r, b);
+
+  /* Path compression */
+  while (r->component_parent[a] != root_a) {
+    next = r->component_parent[a];
+    r->component_parent[a] = root_a;
+    a = next;
+  }
+  while (r->component_parent[b] != root_b) {
+    next = r->component_parent[b];
+    r->component_parent[b] = root_b;
+    b = next;
+  }
+
+  if (root_a == root_b) return;
+
+  /* Union by rank */
+  if (r->component_rank[root_a] < r->component_rank[root_b]) {
+    next = root_a;
+    root_a = root_b;
+    root_b = next;
+  }
+  r->component_parent[root_b] = root_a;
+  r->component_size[root_a] += r->component_size[root_b];
+  if (r->component_rank[root_a] == r->component_rank[root_b]) r->component_rank[root_a]++;
+  r->num_components--;
+}
+
+/*
+ * Kahn's algorithm: music are appended to order once all the relations
+ * reaching them come from music already in it, so order is also the
+ * queue. Returns how many music were ordered (fewer than all if there is
+ * a cycle), or -1 if there is any error.
+ */
+static int radio_kahn(const Radio *r, int *order) {
+  int *in_degree;
+  int head = 0, tail = 0, i, k, w;
+
+  in_degree = (int *)malloc(sizeof(int) * (r->num_music > 0 ? r->num_music : 1));
+  if (!in_degree) return -1;
+
+  for (i = 0; i < r->num_music; i++) {
+    in_degree[i] = r->incoming[i].size;
+    if (in_degree[i] == 0) order[tail++] = i;
+  }
+
+  while (head < tail) {
+    i = order[head++];
+    for (k = 0; k < r->relations[i].size; k++) {
+      w = r->relations[i].dest[k];
+      if (--in_degree[w] == 0) order[tail++] = w;
+    }
+  }
+
+  free(in_degree);
+
+  return tail;
+}
+
+/* Landmarks are dropped when a music or a relation is added */
+static void radio_dropLandmarks(Radio *r) {
+  free(r->hops_from);
+  free(r->hops_to);
+  r->hops_from = NULL;
+  r->hops_to = NULL;
+  r->num_landmarks = 0;
+}
+
+/*
+ * Breadth-first search from a landmark, following the relations backwards
+ * if backward is TRUE. hops[i * num_landmarks] gets the hops of music i.
+ */
+static void radio_landmarkSearch(const Radio *r, int from, Bool backward, unsigned char *hops,
+                                 int *queue, int *dist) {
+  const Relations *rel;
+  int head = 0, tail = 0, i, k, w;
+
+  for (i = 0; i < r->num_music; i++) dist[i] = -1;
+
+  dist[from] = 0;
+  queue[tail++] = from;
+  while (head < tail) {
+    i = queue[head++];
+    rel = (backward == TRUE) ? &r->incoming[i] : &r->relations[i];
+    for (k = 0; k < rel->size; k++) {
+      w = rel->dest[k];
+      if (dist[w] < 0) {
+        dist[w] = dist[i] + 1;
+        queue[tail++] = w;
+      }
+    }
+  }
+
+  for (i = 0; i < r->num_music; i++) {
+    if (dist[i] < 0) {
+      hops[(size_t)i * r->num_landmarks] = RADIO_HOPS_NONE;
+    } else {
+      hops[(size_t)i * r->num_landmarks] =
+          (unsigned char)(dist[i] < RADIO_HOPS_FAR ? dist[i] : RADIO_HOPS_FAR);
+    }
+  }
+}
+
+/*
+ * Bounds of the hops from a to b by the triangle inequality through every
+ * landmark L. Returns FALSE if they show that b cannot be reached from a;
+ * upper is -1 if no landmark gives one.
+ */
+static Bool radio_landmarkBounds(const Radio *r, int a, int b, int *lower, int *upper) {
+  const unsigned char *from_a, *from_b, *to_a, *to_b;
+  int l;
+
+  from_a = r->hops_from + (size_t)a * r->num_landmarks;
+  from_b = r->hops_from + (size_t)b * r->num_landmarks;
+  to_a = r->hops_to + (size_t)a * r->num_landmarks;
+  to_b = r->hops_to + (size_t)b * r->num_landmarks;
+
+  *lower = 0;
+  *upper = -1;
+  for (l = 0; l < r->num_landmarks; l++) {
+    /* d(L, b) <= d(L, a) + d(a, b) */
+    if (from_a[l] < RADIO_HOPS_FAR) {
+      if (from_b[l] == RADIO_HOPS_NONE) return FALSE;
+      if (from_b[l] - from_a[l] > *lower) *lower = from_b[l] - from_a[l];
+    }
+    /* d(a, L) <= d(a, b) + d(b, L) */
+    if (to_b[l] < RADIO_HOPS_FAR) {
+      if (to_a[l] == RADIO_HOPS_NONE) return FALSE;
+      if (to_a[l] - to_b[l] > *lower) *lower = to_a[l] - to_b[l];
+    }
+    /* d(a, b) <= d(a, L) + d(L, b) */
+    if (to_a[l] < RADIO_HOPS_FAR && from_b[l] < RADIO_HOPS_FAR &&
+        (*upper < 0 || to_a[l] + from_b[l] < *upper)) {
+      *upper = to_a[l] + from_b[l];
+    }
+  }
+
+  return TRUE;
+}
+
+/*
+ * Exact hops from a to b with a bidirectional breadth-first search, which
+ * expands a whole level of the smaller frontier each time. If upper >= 0
+ * there is a path of that length, so the search stops as soon as no
+ * shorter one is left. Returns -1 if there is no path or any error.
+ */
+static int radio_hopDistance(const Radio *r, int a, int b, int upper) {
+  const Relations *rel;
+  int *work, *dist_f, *dist_b, *queue_f, *queue_b;
+  int head_f = 0, tail_f = 0, head_b = 0, tail_b = 0, level_f = 0, level_b = 0;
+  int best = -1, end, i, k, w;
+
+  work = (int *)malloc(sizeof(int) * 4 * r->num_music);
+  if (!work) return -1;
+  dist_f = work;
+  dist_b = work + r->num_music;
+  queue_f = work + 2 * r->num_music;
+  queue_b = work + 3 * r->num_music;
+
+  for (i = 0; i < r->num_music; i++) dist_f[i] = dist_b[i] = -1;
+  dist_f[a] = 0;
+  queue_f[tail_f++] = a;
+  dist_b[b] = 0;
+  queue_b[tail_b++] = b;
+
+  while (best < 0 && head_f < tail_f && head_b < tail_b) {
+    /* Every path of level_f + level_b hops or less has been seen */
+    if (upper >= 0 && level_f + level_b + 1 >= upper) {
+      best = upper;
+    } else if (tail_f - head_f <= tail_b - head_b) {
+      for (end = tail_f; head_f < end;) {
+        i = queue_f[head_f++];
+        rel = &r->relations[i];
+        for (k = 0; k < rel->size; k++) {
+          w = rel->dest[k];
+          if (dist_f[w] >= 0) continue;
+          dist_f[w] = level_f + 1;
+          queue_f[tail_f++] = w;
+          if (dist_b[w] >= 0 && (best < 0 || level_f + 1 + dist_b[w] < best)) {
+            best = level_f + 1 + dist_b[w];
+          }
+        }
+      }
+      level_f++;
+    } else {
+      for (end = tail_b; head_b < end;) {
+        i = queue_b[head_b++];
+        rel = &r->incoming[i];
+        for (k = 0; k < rel->size; k++) {
+          w = rel->dest[k];
+          if (dist_b[w] >= 0) continue;
+          dist_b[w] = level_b + 1;
+          queue_b[tail_b++] = w;
+          if (dist_f[w] >= 0 && (best < 0 || level_b + 1 + dist_f[w] < best)) {
+            best = level_b + 1 + dist_f[w];
+          }
+        }
+      }
+      level_b++;
+    }
+  }
+
+  free(work);
+
+  return best;
+}
+
+/*
+ * Prints a music visited by a search, with a line break. Concurrent
+ * searches keep the visits in the scratch marks, not in the shared
+ * handles, so they print the state the sequential search would set.
+ */
+static int radio_printVisited(FILE *pf, const Music *m, const RadioScratch *scratch) {
+  if (!m) return -1;
+  if (!scratch) return music_line_print(pf, m);
+
+  return fprintf(pf, "[%ld, %s, %s, %hu, %d, %d]\n", music_getId(m), music_getTitle(m),
+                 music_getArtist(m), music_getDuration(m), (int)LISTENED, music_getIndex(m));
+}
+
+/* A search whose destination is in another component only visits the origin */
+static Status radio_searchUnreachable(FILE *pf, Radio *r, RadioScratch *scratch, int i_from) {
+  radio_visit(r, scratch, i_from);
+  if (radio_loadMusic(r, i_from) == ERROR) return ERROR;
+  if (radio_printVisited(pf, r->songs[i_from], scratch) < 0) return ERROR;
+
+  return OK;
+}
+
+/*
+ * Search of the concurrent mode. Every music is marked when it is added
+ * to work, so work never holds more than one entry per music: a stack
+ * from the end for the depth-first search, a queue from the start for
+ * the breadth-first one. It visits the music in the order of the
+ * searches over the Stack and Queue of the sequential mode.
+ */
+static Status radio_scratchSearch(FILE *pf, Radio *r, RadioScratch *scratch, int i_from,
+                                  int i_to, Bool depth) {
+  const Relations *rel;
+  int head = 0, tail = 0, row, i;
+
+  radio_visit(r, scratch, i_from);
+  scratch->work[tail++] = i_from;
+
+  while (head < tail) {
+    row = (depth == TRUE) ? scratch->work[--tail] : scratch->work[head++];
+
+    if (radio_printVisited(pf, r->songs[row], scratch) < 0) return ERROR;
+    if (row == i_to) return OK;
+
+    rel = &r->relations[row];
+    for (i = 0; i < rel->size; i++) {
+      if (radio_visit(r, scratch, rel->dest[i]) == TRUE) scratch->work[tail++] = rel->dest[i];
+    }
+  }
+
+  return OK;
+}
+
+/* Inserts a new relation at position pos of the origin list, and its reverse */
+static Status radio_addRelation(Radio *r, int i_orig, int i_dest, int pos, double weight) {
+  Bool found;
+  int in_pos;
+
+  in_pos = radio_findRelation(&r->incoming[i_dest], i_orig, &found);
+  if (radio_insertRelation(&r->incoming[i_dest], in_pos, i_orig, RADIO_DEFAULT_WEIGHT) == ERROR) {
+    return ERROR;
+  }
+
+  if (radio_insertRelation(&r->relations[i_orig], pos, i_dest, weight) == ERROR) {
+    r->incoming[i_dest].size--;
+    memmove(&r->incoming[i_dest].dest[in_pos], &r->incoming[i_dest].dest[in_pos + 1],
+            sizeof(int) * (r->incoming[i_dest].size - in_pos));
+    return ERROR;
   }
 
+  r->num_relations++;
+  radio_joinComponents(r, i_orig, i_dest);
+  if (r->num_landmarks > 0) radio_dropLandmarks(r);
+
   return OK;
 }
 
+/* The lock is only taken in concurrent mode */
+static void radio_readLock(const Radio *r) {
+  if (r->concurrent == TRUE) pthread_rwlock_rdlock((pthread_rwlock_t *)&r->lock);
+}
+
+static void radio_writeLock(Radio *r) {
+  if (r->concurrent == TRUE) pthread_rwlock_wrlock(&r->lock);
+}
+
+static void radio_unlock(const Radio *r) {
+  if (r->concurrent == TRUE) pthread_rwlock_unlock((pthread_rwlock_t *)&r->lock);
+}
+
+static void radio_scratchCreateKey(void) {
+  if (pthread_key_create(&radio_scratch_key, radio_scratchFree) == 0) radio_scratch_ready = TRUE;
+}
+
+/* Called when a thread finishes */
+static void radio_scratchFree(void *scratch) {
+  if (!scratch) return;
+
+  free(((RadioScratch *)scratch)->mark);
+  free(((RadioScratch *)scratch)->work);
+  free(scratch);
+}
+
+/* Scratch of the calling thread with room for n music, with every mark cleared */
+static RadioScratch *radio_getScratch(int n) {
+  RadioScratch *sc;
+  unsigned int *mark;
+  int *work;
+
+  pthread_once(&radio_scratch_once, radio_scratchCreateKey);
+  if (radio_scratch_ready == FALSE) return NULL;
+
+  sc = (RadioScratch *)pthread_getspecific(radio_scratch_key);
+  if (!sc) {
+    sc = (RadioScratch *)calloc(1, sizeof(RadioScratch));
+    if (!sc) return NULL;
+    if (pthread_setspecific(radio_scratch_key, sc) != 0) {
+      free(sc);
+      return NULL;
+    }
+  }
+
+  if (sc->capacity < n) {
+    mark = (unsigned int *)calloc(n, sizeof(unsigned int));
+    work = (int *)malloc(sizeof(int) * n);
+    if (!mark || !work) {
+      free(mark);
+      free(work);
+      return NULL;
+    }
+    free(sc->mark);
+    free(sc->work);
+    sc->mark = mark;
+    sc->work = work;
+    sc->capacity = n;
+    sc->epoch = 0;
+  }
+
+  /* A new epoch clears every mark in O(1) */
+  sc->epoch++;
+  if (sc->epoch == 0) {
+    memset(sc->mark, 0, sizeof(unsigned int) * sc->capacity);
+    sc->epoch = 1;
+  }
+
+  return sc;
+}
+
+/* Marks music i as visited; returns FALSE if it already was */
+static Bool radio_visit(Radio *r, RadioScratch *scratch, int i) {
+  if (scratch) {
+    if (scratch->mark[i] == scratch->epoch) return FALSE;
+    scratch->mark[i] = scratch->epoch;
+    return TRUE;
+  }
+
+  if (r->states[i] != NOT_LISTENED) return FALSE;
+  r->states[i] = LISTENED;
+  /* A music that cannot be loaded keeps a NULL handle, which makes the search fail */
+  if (radio_loadMusic(r, i) == OK) music_setState(r->songs[i], LISTENED);
+
+  return TRUE;
+}
+
+/*
+ * Similarity of two music from their common outgoing and incoming
+ * relations. common is a scratch array with room for any relation list.
+ */
+static double radio_similarity(const Radio *r, int a, int b, RadioSimilarity sim, int *common) {
+  const Relations *lists_a[2], *lists_b[2];
+  int l, k, n_common, n_union = 0, total = 0, degree;
+  double score = 0.0;
+
+  lists_a[0] = &r->relations[a];
+  lists_a[1] = &r->incoming[a];
+  lists_b[0] = &r->relations[b];
+  lists_b[1] = &r->incoming[b];
+
+  for (l = 0; l < 2; l++) {
+    n_common = intersect_list(lists_a[l]->dest, lists_a[l]->size, lists_b[l]->dest,
+                              lists_b[l]->size, common);
+    if (n_common <= 0) {
+      n_union += lists_a[l]->size + lists_b[l]->size;
+      continue;
+    }
+
+    total += n_common;
+    n_union += lists_a[l]->size + lists_b[l]->size - n_common;
+    for (k = 0; sim == RADIO_ADAMIC_ADAR && k < n_common; k++) {
+      /* A common neighbour has at least two relations, so the log is positive */
+      degree = r->relations[common[k]].size + r->incoming[common[k]].size;
+      score += 1.0 / log((double)degree);
+    }
+  }
+
+  if (sim == RADIO_JACCARD) return (n_union > 0) ? (double)total / n_union : 0.0;
+
+  return score;
+}
+
 /*----------------------------------------------------------------------------------------*/
 /**
  * @brief Creates a new empty radio.
@@ -59,19 +739,38 @@ static Status radio_resetMusicStates(Radio *r) {
  **/
 Radio *radio_init() {
   Radio *new_radio;
-  int i, j;
+  int i;
 
   new_radio = (Radio *)malloc(sizeof(Radio));
   if (!new_radio) return NULL;
 
   new_radio->num_music = 0;
   new_radio->num_relations = 0;
+  new_radio->num_components = 0;
+  new_radio->concurrent = FALSE;
+  new_radio->lazy = FALSE;
+  new_radio->num_landmarks = 0;
+  new_radio->hops_from = NULL;
+  new_radio->hops_to = NULL;
+  new_radio->names = NULL;
+  new_radio->names_size = 0;
+  new_radio->names_capacity = 0;
+  for (i = 0; i < RADIO_ID_TABLE; i++) new_radio->id_table[i] = -1;
+  if (pthread_rwlock_init(&new_radio->lock, NULL) != 0) {
+    free(new_radio);
+    return NULL;
+  }
 
   for (i = 0; i < MAX_MSC; i++) {
     new_radio->songs[i] = NULL;
-    for (j = 0; j < MAX_MSC; j++) {
-      new_radio->relations[i][j] = FALSE;
-    }
+    new_radio->relations[i].dest = NULL;
+    new_radio->relations[i].weight = NULL;
+    new_radio->relations[i].size = 0;
+    new_radio->relations[i].capacity = 0;
+    new_radio->incoming[i].dest = NULL;
+    new_radio->incoming[i].weight = NULL;
+    new_radio->incoming[i].size = 0;
+    new_radio->incoming[i].capacity = 0;
   }
 
   return new_radio;
@@ -91,30 +790,117 @@ void radio_free(Radio *r) {
 
   for (i = 0; i < r->num_music; i++) {
     music_free(r->songs[i]);
+    free(r->relations[i].dest);
+    free(r->relations[i].weight);
+    free(r->incoming[i].dest);
   }
 
+  pthread_rwlock_destroy(&r->lock);
+  free(r->hops_from);
+  free(r->hops_to);
+  free(r->names);
   free(r);
 }
 
 /**
- * @brief Inserts a new music in a radio.
+ * @brief Turns the concurrent mode of a radio on or off.
  *
- * Creates a music by calling music_initFromString and adds it to
- * a radio. If a music with the same id already exists in the radio,
- * it is not added.
+ * In concurrent mode the functions that add music or relations take a
+ * write lock and all the queries take a read lock, so any number of
+ * threads can query the radio while others modify it. Searches mark the
+ * visited music in a scratch area of the calling thread instead of
+ * changing the state of the music, and print them as LISTENED, as the
+ * searches of the sequential mode do.
  *
- * @param r Pointer to the radio.
- * @param desc Description of the music.
+ * Turning it on loads the music added in lazy mode, and music added while
+ * it is on are always loaded at once.
  *
- * @return Returns OK if the music could be created (or if it exists
- * already), ERROR otherwise.
- **/
-Status radio_newMusic(Radio *r, char *desc) {
+ * Must be called while no other thread uses the radio.
+ *
+ * @param r Pointer to radio.
+ * @param concurrent TRUE to turn the concurrent mode on, FALSE otherwise.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setConcurrent(Radio *r, Bool concurrent) {
+  if (!r) return ERROR;
+  if (concurrent == TRUE && radio_loadAll(r) == ERROR) return ERROR;
+
+  r->concurrent = (concurrent == TRUE) ? TRUE : FALSE;
+
+  return OK;
+}
+
+/**
+ * @brief Turns the lazy mode of a radio on or off.
+ *
+ * In lazy mode radio_newMusic only reads the id and the state of the
+ * music and keeps its description; the music is parsed the first time
+ * its handle, title, artist or duration is needed. A description that
+ * cannot be parsed then makes that access fail. Turning the lazy mode
+ * off loads all the music that are still pending.
+ *
+ * Jobs that only touch a few music of a big radio should turn it on
+ * before radio_readFromFile.
+ *
+ * @param r Pointer to radio.
+ * @param lazy TRUE to turn the lazy mode on, FALSE otherwise.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setLazy(Radio *r, Bool lazy) {
+  Status st = OK;
+
+  if (!r) return ERROR;
+
+  radio_writeLock(r);
+  r->lazy = (lazy == TRUE) ? TRUE : FALSE;
+  if (r->lazy == FALSE) st = radio_loadAll(r);
+  radio_unlock(r);
+
+  return st;
+}
+
+/* Adds a music keeping only its id, state and description */
+static Status radio_newLazyMusic(Radio *r, char *desc) {
+  long new_id;
+  State state;
+  unsigned int h;
+  int i;
+
+  if (music_scanDescription(desc, &new_id, &state) == ERROR) return ERROR;
+  if (radio_getIndexById(r, new_id) >= 0) return OK;
+
+  i = r->num_music;
+  if (radio_addName(r, desc, &r->descs[i]) == ERROR) return ERROR;
+  r->songs[i] = NULL;
+  r->ids[i] = new_id;
+  r->durations[i] = 0;
+  r->states[i] = state;
+
+  h = radio_hashId(new_id);
+  while (r->id_table[h] >= 0) h = (h + 1) & (RADIO_ID_TABLE - 1);
+  r->id_table[h] = i;
+
+  r->component_parent[r->num_music] = r->num_music;
+  r->component_rank[r->num_music] = 0;
+  r->component_size[r->num_music] = 1;
+  r->num_components++;
+  r->num_music++;
+
+  return OK;
+}
+
+static Status radio_newMusicUnlocked(Radio *r, char *desc) {
   Music *new_music;
   long new_id;
+  unsigned int h;
+  int i;
 
   if (!r || !desc) return ERROR;
   if (r->num_music >= MAX_MSC) return ERROR;
+  if (r->num_landmarks > 0) radio_dropLandmarks(r);
+  if (r->lazy == TRUE && r->concurrent == FALSE) return radio_newLazyMusic(r, desc);
 
   new_music = music_initFromString(desc);
   if (!new_music) return ERROR;
@@ -130,12 +916,71 @@ Status radio_newMusic(Radio *r, char *desc) {
     return ERROR;
   }
 
-  r->songs[r->num_music] = new_music;
+  i = r->num_music;
+  if (radio_addName(r, music_getTitle(new_music), &r->titles[i]) == ERROR ||
+      radio_addName(r, music_getArtist(new_music), &r->artists[i]) == ERROR) {
+    music_free(new_music);
+    return ERROR;
+  }
+  r->songs[i] = new_music;
+  r->ids[i] = new_id;
+  r->durations[i] = music_getDuration(new_music);
+  r->states[i] = music_getState(new_music);
+
+  h = radio_hashId(new_id);
+  while (r->id_table[h] >= 0) h = (h + 1) & (RADIO_ID_TABLE - 1);
+  r->id_table[h] = i;
+
+  r->component_parent[r->num_music] = r->num_music;
+  r->component_rank[r->num_music] = 0;
+  r->component_size[r->num_music] = 1;
+  r->num_components++;
   r->num_music++;
 
   return OK;
 }
 
+/**
+ * @brief Inserts a new music in a radio.
+ *
+ * Creates a music by calling music_initFromString and adds it to
+ * a radio. If a music with the same id already exists in the radio,
+ * it is not added.
+ *
+ * @param r Pointer to the radio.
+ * @param desc Description of the music.
+ *
+ * @return Returns OK if the music could be created (or if it exists
+ * already), ERROR otherwise.
+ **/
+Status radio_newMusic(Radio *r, char *desc) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  radio_writeLock(r);
+  st = radio_newMusicUnlocked(r, desc);
+  radio_unlock(r);
+
+  return st;
+}
+
+static Status radio_newRelationUnlocked(Radio *r, long orig, long dest) {
+  int i_orig, i_dest, pos;
+  Bool found;
+
+  if (!r) return ERROR;
+
+  i_orig = radio_getIndexById(r, orig);
+  i_dest = radio_getIndexById(r, dest);
+  if (i_orig < 0 || i_dest < 0) return ERROR;
+
+  pos = radio_findRelation(&r->relations[i_orig], i_dest, &found);
+  if (found == TRUE) return OK;
+
+  return radio_addRelation(r, i_orig, i_dest, pos, RADIO_DEFAULT_WEIGHT);
+}
+
 /**
  * @brief Creates a relation between two music of a radio.
  *
@@ -146,23 +991,66 @@ Status radio_newMusic(Radio *r, char *desc) {
  * @param orig ID of the origin music.
  * @param dest ID of the destination music.
  *
- * @return OK if the relation could be added to the radio, ERROR otherwise.
+ * @return OK if the relation could be added to the radio, ERROR otherwise.
+ **/
+Status radio_newRelation(Radio *r, long orig, long dest) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  radio_writeLock(r);
+  st = radio_newRelationUnlocked(r, orig, dest);
+  radio_unlock(r);
+
+  return st;
+}
+
+static Status radio_newWeightedRelationUnlocked(Radio *r, long orig, long dest, double weight) {
+  Relations *rel;
+  int i_orig, i_dest, pos, i;
+  Bool found;
+
+  if (!r || !(weight >= 0.0)) return ERROR;
+
+  i_orig = radio_getIndexById(r, orig);
+  i_dest = radio_getIndexById(r, dest);
+  if (i_orig < 0 || i_dest < 0) return ERROR;
+
+  rel = &r->relations[i_orig];
+  pos = radio_findRelation(rel, i_dest, &found);
+  if (found == FALSE) return radio_addRelation(r, i_orig, i_dest, pos, weight);
+
+  if (!rel->weight) {
+    if (weight == RADIO_DEFAULT_WEIGHT) return OK;
+    rel->weight = (double *)malloc(sizeof(double) * rel->capacity);
+    if (!rel->weight) return ERROR;
+    for (i = 0; i < rel->size; i++) rel->weight[i] = RADIO_DEFAULT_WEIGHT;
+  }
+  rel->weight[pos] = weight;
+
+  return OK;
+}
+
+/**
+ * @brief Creates (or updates) a weighted relation between two music.
+ *
+ * @param r Pointer to the radio.
+ * @param orig ID of the origin music.
+ * @param dest ID of the destination music.
+ * @param weight Weight of the relation, greater or equal than 0.
+ *
+ * @return OK if the relation could be added or updated, ERROR otherwise.
  **/
-Status radio_newRelation(Radio *r, long orig, long dest) {
-  int i_orig, i_dest;
+Status radio_newWeightedRelation(Radio *r, long orig, long dest, double weight) {
+  Status st;
 
   if (!r) return ERROR;
 
-  i_orig = radio_getIndexById(r, orig);
-  i_dest = radio_getIndexById(r, dest);
-  if (i_orig < 0 || i_dest < 0) return ERROR;
-
-  if (r->relations[i_orig][i_dest] == TRUE) return OK;
-
-  r->relations[i_orig][i_dest] = TRUE;
-  r->num_relations++;
+  radio_writeLock(r);
+  st = radio_newWeightedRelationUnlocked(r, orig, dest, weight);
+  radio_unlock(r);
 
-  return OK;
+  return st;
 }
 
 /**
@@ -175,8 +1063,15 @@ Status radio_newRelation(Radio *r, long orig, long dest) {
  * ID id, FALSE otherwise.
  **/
 Bool radio_contains(const Radio *r, long id) {
+  int i;
+
   if (!r || id < 0) return FALSE;
-  return (radio_getIndexById(r, id) >= 0) ? TRUE : FALSE;
+
+  radio_readLock(r);
+  i = radio_getIndexById(r, id);
+  radio_unlock(r);
+
+  return (i >= 0) ? TRUE : FALSE;
 }
 
 /**
@@ -188,8 +1083,15 @@ Bool radio_contains(const Radio *r, long id) {
  * there is any error.
  **/
 int radio_getNumberOfMusic(const Radio *r) {
+  int n;
+
   if (!r) return -1;
-  return r->num_music;
+
+  radio_readLock(r);
+  n = r->num_music;
+  radio_unlock(r);
+
+  return n;
 }
 
 /**
@@ -201,8 +1103,30 @@ int radio_getNumberOfMusic(const Radio *r) {
  * there is any error.
  **/
 int radio_getNumberOfRelations(const Radio *r) {
+  int n;
+
   if (!r) return -1;
-  return r->num_relations;
+
+  radio_readLock(r);
+  n = r->num_relations;
+  radio_unlock(r);
+
+  return n;
+}
+
+static Bool radio_relationExistsUnlocked(const Radio *r, long orig, long dest) {
+  int i_orig, i_dest;
+  Bool found;
+
+  if (!r) return FALSE;
+
+  i_orig = radio_getIndexById(r, orig);
+  i_dest = radio_getIndexById(r, dest);
+  if (i_orig < 0 || i_dest < 0) return FALSE;
+
+  radio_findRelation(&r->relations[i_orig], i_dest, &found);
+
+  return found;
 }
 
 /**
@@ -216,15 +1140,65 @@ int radio_getNumberOfRelations(const Radio *r) {
  *  to dest, FALSE otherwise.
  **/
 Bool radio_relationExists(const Radio *r, long orig, long dest) {
-  int i_orig, i_dest;
+  Bool ret;
 
   if (!r) return FALSE;
 
+  radio_readLock(r);
+  ret = radio_relationExistsUnlocked(r, orig, dest);
+  radio_unlock(r);
+
+  return ret;
+}
+
+static double radio_getRelationWeightUnlocked(const Radio *r, long orig, long dest) {
+  const Relations *rel;
+  int i_orig, i_dest, pos;
+  Bool found;
+
+  if (!r) return -1;
+
   i_orig = radio_getIndexById(r, orig);
   i_dest = radio_getIndexById(r, dest);
-  if (i_orig < 0 || i_dest < 0) return FALSE;
+  if (i_orig < 0 || i_dest < 0) return -1;
+
+  rel = &r->relations[i_orig];
+  pos = radio_findRelation(rel, i_dest, &found);
+  if (found == FALSE) return -1;
+
+  return rel->weight ? rel->weight[pos] : RADIO_DEFAULT_WEIGHT;
+}
+
+/**
+ * @brief Returns the weight of the relation between a pair of music.
+ *
+ * @param r Pointer to the radio.
+ * @param orig ID of the origin music.
+ * @param dest ID of the destination music.
+ *
+ * @return The weight of the relation, or -1 if there is no such relation.
+ **/
+double radio_getRelationWeight(const Radio *r, long orig, long dest) {
+  double ret;
+
+  if (!r) return -1;
+
+  radio_readLock(r);
+  ret = radio_getRelationWeightUnlocked(r, orig, dest);
+  radio_unlock(r);
+
+  return ret;
+}
+
+static int radio_getNumberOfRelationsFromIdUnlocked(const Radio *r, long id) {
+  int i_orig;
+
+  if (!r) return -1;
+
+  i_orig = radio_getIndexById(r, id);
+  if (i_orig < 0) return -1;
 
-  return r->relations[i_orig][i_dest];
+  return r->relations[i_orig].size;
 }
 
 /**
@@ -237,18 +1211,36 @@ Bool radio_relationExists(const Radio *r, long orig, long dest) {
  * music with ID id, or -1 if there is any error.
  **/
 int radio_getNumberOfRelationsFromId(const Radio *r, long id) {
-  int i_orig, i, total = 0;
+  int ret;
 
   if (!r) return -1;
 
+  radio_readLock(r);
+  ret = radio_getNumberOfRelationsFromIdUnlocked(r, id);
+  radio_unlock(r);
+
+  return ret;
+}
+
+static long *radio_getRelationsFromIdUnlocked(const Radio *r, long id) {
+  long *ids;
+  int i_orig, i, count;
+
+  if (!r) return NULL;
+
   i_orig = radio_getIndexById(r, id);
-  if (i_orig < 0) return -1;
+  if (i_orig < 0) return NULL;
 
-  for (i = 0; i < r->num_music; i++) {
-    if (r->relations[i_orig][i] == TRUE) total++;
+  count = r->relations[i_orig].size;
+
+  ids = (long *)malloc(sizeof(long) * (count > 0 ? count : 1));
+  if (!ids) return NULL;
+
+  for (i = 0; i < count; i++) {
+    ids[i] = r->ids[r->relations[i_orig].dest[i]];
   }
 
-  return total;
+  return ids;
 }
 
 /**
@@ -264,33 +1256,225 @@ int radio_getNumberOfRelationsFromId(const Radio *r, long id) {
  * the music with ID id is connected, or NULL if there is any error.
  */
 long *radio_getRelationsFromId(const Radio *r, long id) {
-  long *ids;
-  int i_orig, i, count, index = 0;
+  long *ret;
 
   if (!r) return NULL;
 
-  i_orig = radio_getIndexById(r, id);
-  if (i_orig < 0) return NULL;
+  radio_readLock(r);
+  ret = radio_getRelationsFromIdUnlocked(r, id);
+  radio_unlock(r);
 
-  count = radio_getNumberOfRelationsFromId(r, id);
-  if (count < 0) return NULL;
+  return ret;
+}
 
-  ids = (long *)malloc(sizeof(long) * (count > 0 ? count : 1));
-  if (!ids) return NULL;
+static Bool radio_sameComponentUnlocked(const Radio *r, long a, long b) {
+  int i_a, i_b;
 
-  for (i = 0; i < r->num_music; i++) {
-    if (r->relations[i_orig][i] == TRUE) {
-      ids[index] = music_getId(r->songs[i]);
-      index++;
+  if (!r) return FALSE;
+
+  i_a = radio_getIndexById(r, a);
+  i_b = radio_getIndexById(r, b);
+  if (i_a < 0 || i_b < 0) return FALSE;
+
+  return (radio_findComponent(r, i_a) == radio_findComponent(r, i_b)) ? TRUE : FALSE;
+}
+
+/**
+ * @brief Checks if two music are in the same weakly connected component.
+ *
+ * @param r Pointer to the radio.
+ * @param a ID of one music.
+ * @param b ID of the other music.
+ *
+ * @return TRUE if a and b are connected ignoring the direction of the
+ * relations, FALSE otherwise.
+ */
+Bool radio_sameComponent(const Radio *r, long a, long b) {
+  Bool ret;
+
+  if (!r) return FALSE;
+
+  radio_readLock(r);
+  ret = radio_sameComponentUnlocked(r, a, b);
+  radio_unlock(r);
+
+  return ret;
+}
+
+/**
+ * @brief Returns the number of weakly connected components of a radio.
+ *
+ * @param r Pointer to the radio.
+ *
+ * @return The number of components, or -1 if there is any error.
+ */
+int radio_getNumberOfComponents(const Radio *r) {
+  int n;
+
+  if (!r) return -1;
+
+  radio_readLock(r);
+  n = r->num_components;
+  radio_unlock(r);
+
+  return n;
+}
+
+static int radio_getComponentSizeUnlocked(const Radio *r, long id) {
+  int i;
+
+  if (!r) return -1;
+
+  i = radio_getIndexById(r, id);
+  if (i < 0) return -1;
+
+  return r->component_size[radio_findComponent(r, i)];
+}
+
+/**
+ * @brief Returns the size of the weakly connected component of a music.
+ *
+ * @param r Pointer to the radio.
+ * @param id ID of the music.
+ *
+ * @return The number of music in its component, or -1 if there is any
+ * error.
+ */
+int radio_getComponentSize(const Radio *r, long id) {
+  int ret;
+
+  if (!r) return -1;
+
+  radio_readLock(r);
+  ret = radio_getComponentSizeUnlocked(r, id);
+  radio_unlock(r);
+
+  return ret;
+}
+
+static long *radio_similarSongsUnlocked(const Radio *r, long id, int k, RadioSimilarity sim,
+                                        double *scores, int *n_similar) {
+  const Relations *via[2], *back;
+  RadioScratch *scratch;
+  Heap *best;
+  int *candidates, *common, *chosen;
+  long *ids = NULL;
+  double score, worst;
+  int i, l, w, c, v, slot, n_candidates = 0, max_candidates = 0, max_size;
+  Status st = OK;
+
+  if (!r || k <= 0 || !n_similar) return NULL;
+  *n_similar = 0;
+
+  i = radio_getIndexById(r, id);
+  if (i < 0) return NULL;
+
+  /* Everything is sized from the neighbourhood of music i, not from the radio */
+  via[0] = &r->relations[i];
+  via[1] = &r->incoming[i];
+  for (l = 0; l < 2; l++) {
+    for (w = 0; w < via[l]->size; w++) {
+      back = (l == 0) ? &r->incoming[via[l]->dest[w]] : &r->relations[via[l]->dest[w]];
+      max_candidates += back->size;
+    }
+  }
+  if (max_candidates > r->num_music) max_candidates = r->num_music;
+  if (k > max_candidates) k = max_candidates;
+  /* An intersection with a list of music i is never longer than that list */
+  max_size = (via[0]->size > via[1]->size) ? via[0]->size : via[1]->size;
+
+  scratch = radio_getScratch(r->num_music);
+  best = heap_new(k);
+  chosen = (int *)malloc(sizeof(int) * (k > 0 ? k : 1));
+  candidates = (int *)malloc(sizeof(int) * (max_candidates > 0 ? max_candidates : 1));
+  common = (int *)malloc(sizeof(int) * (max_size > 0 ? max_size : 1));
+  if (!scratch || !best || !chosen || !candidates || !common) st = ERROR;
+
+  /* Candidates: music sharing a destination or an origin with music i */
+  if (st == OK) scratch->mark[i] = scratch->epoch;
+  for (l = 0; st == OK && l < 2; l++) {
+    for (w = 0; w < via[l]->size; w++) {
+      back = (l == 0) ? &r->incoming[via[l]->dest[w]] : &r->relations[via[l]->dest[w]];
+      for (c = 0; c < back->size; c++) {
+        if (scratch->mark[back->dest[c]] != scratch->epoch) {
+          scratch->mark[back->dest[c]] = scratch->epoch;
+          candidates[n_candidates++] = back->dest[c];
+        }
+      }
     }
   }
 
+  /*
+   * Keep the k best in a min-heap keyed by similarity. The heap holds
+   * slots of chosen, and the slot of the worst music is given to the one
+   * that replaces it.
+   */
+  for (c = 0; st == OK && c < n_candidates; c++) {
+    score = radio_similarity(r, i, candidates[c], sim, common);
+    if (heap_size(best) < (size_t)k) {
+      slot = (int)heap_size(best);
+      chosen[slot] = candidates[c];
+      st = heap_push(best, slot, score);
+    } else if (heap_top(best, &worst) >= 0 && score > worst) {
+      slot = heap_pop(best, NULL);
+      chosen[slot] = candidates[c];
+      st = heap_push(best, slot, score);
+    }
+  }
+
+  if (st == OK && heap_size(best) > 0) {
+    *n_similar = (int)heap_size(best);
+    ids = (long *)malloc(sizeof(long) * *n_similar);
+    for (c = *n_similar - 1; ids && c >= 0; c--) {
+      v = chosen[heap_pop(best, &score)];
+      ids[c] = r->ids[v];
+      if (scores) scores[c] = score;
+    }
+    if (!ids) *n_similar = 0;
+  }
+
+  heap_free(best);
+  free(chosen);
+  free(candidates);
+  free(common);
+
   return ids;
 }
 
+/**
+ * @brief Finds the music most similar to a given one.
+ *
+ * @param r Pointer to the radio.
+ * @param id ID of the music.
+ * @param k Maximum number of similar music to return.
+ * @param sim Similarity measure.
+ * @param scores Output array with k positions for the similarity of each
+ * returned music (can be NULL).
+ * @param n_similar Output, number of ids returned.
+ *
+ * @return An array with the ids of the most similar music, or NULL if
+ * there is any error or no similar music.
+ */
+long *radio_similarSongs(const Radio *r, long id, int k, RadioSimilarity sim, double *scores,
+                         int *n_similar) {
+  long *ret;
+
+  if (!r) return NULL;
+
+  radio_readLock(r);
+  ret = radio_similarSongsUnlocked(r, id, k, sim, scores, n_similar);
+  radio_unlock(r);
+
+  return ret;
+}
+
 /**
  * @brief Returns the Music stored at a given position of the radio.
  *
+ * The id, title, artist and duration of the music are also kept by the
+ * radio in contiguous arrays, so they must not be modified through the
+ * returned handle.
+ *
  * @param r Pointer to the radio.
  * @param index Position of the song in the radio.
  *
@@ -298,28 +1482,200 @@ long *radio_getRelationsFromId(const Radio *r, long id) {
  * there is any error.
  */
 Music *radio_getMusicAt(const Radio *r, int index) {
-  if (!r || index < 0 || index >= r->num_music) return NULL;
+  Music *m = NULL;
 
-  return r->songs[index];
+  if (!r || index < 0) return NULL;
+
+  /* Music are never removed, so the pointer stays valid after unlocking */
+  radio_readLock(r);
+  if (index < r->num_music && radio_loadMusic(r, index) == OK) m = r->songs[index];
+  radio_unlock(r);
+
+  return m;
 }
 
 /**
- * @brief Prints a radio.
+ * @brief Returns the id of the music at a given position of the radio.
  *
- * Prints the radio g to the file pf.
- * The format to be followed is: print a line by music with the
- * information associated with the music and then their connections
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The id of the music, or -1 if there is any error.
+ */
+long radio_getIdAt(const Radio *r, int index) {
+  long id = -1;
+
+  if (!r || index < 0) return -1;
+
+  radio_readLock(r);
+  if (index < r->num_music) id = r->ids[index];
+  radio_unlock(r);
+
+  return id;
+}
+
+/**
+ * @brief Returns the duration of the music at a given position of the radio.
  *
- * @param pf File descriptor.
  * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
  *
- * @return The number of characters printed, or -1 if there is any error.
+ * @return The duration of the music, or (unsigned short)-1 if there is any
+ * error.
  */
-int radio_print(FILE *pf, const Radio *r) {
+unsigned short radio_getDurationAt(const Radio *r, int index) {
+  unsigned short duration = (unsigned short)-1;
+
+  if (!r || index < 0) return duration;
+
+  radio_readLock(r);
+  if (index < r->num_music && radio_loadMusic(r, index) == OK) duration = r->durations[index];
+  radio_unlock(r);
+
+  return duration;
+}
+
+/**
+ * @brief Returns the title of the music at a given position of the radio.
+ *
+ * The string lives in a pool of the radio and is valid until the next
+ * music is added. In concurrent mode another thread can add one at any
+ * time, so there the title must be taken from the handle returned by
+ * radio_getMusicAt, which keeps its own copy.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The title of the music, or NULL if there is any error.
+ */
+const char *radio_getTitleAt(const Radio *r, int index) {
+  const char *title = NULL;
+
+  if (!r || index < 0) return NULL;
+
+  radio_readLock(r);
+  if (index < r->num_music && radio_loadMusic(r, index) == OK) {
+    title = r->names + r->titles[index];
+  }
+  radio_unlock(r);
+
+  return title;
+}
+
+/**
+ * @brief Returns the artist of the music at a given position of the radio.
+ *
+ * The string lives in a pool of the radio and is valid until the next
+ * music is added. In concurrent mode another thread can add one at any
+ * time, so there the artist must be taken from the handle returned by
+ * radio_getMusicAt, which keeps its own copy.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The artist of the music, or NULL if there is any error.
+ */
+const char *radio_getArtistAt(const Radio *r, int index) {
+  const char *artist = NULL;
+
+  if (!r || index < 0) return NULL;
+
+  radio_readLock(r);
+  if (index < r->num_music && radio_loadMusic(r, index) == OK) {
+    artist = r->names + r->artists[index];
+  }
+  radio_unlock(r);
+
+  return artist;
+}
+
+/**
+ * @brief Builds a compact (CSR) copy of the radio relations.
+ *
+ * @param r Pointer to the radio.
+ * @param n_music Output, number of music in the copy.
+ * @param offsets Output, address where the offsets array is stored.
+ * @param targets Output, address where the targets array is stored.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getAdjacency(const Radio *r, int *n_music, int **offsets, int **targets) {
+  return radio_getWeightedAdjacency(r, n_music, offsets, targets, NULL);
+}
+
+static Status radio_getWeightedAdjacencyUnlocked(const Radio *r, int *n_music, int **offsets,
+                                                 int **targets, double **weights) {
+  int *off, *tgt;
+  double *wgt = NULL;
+  int i, j, k = 0, m;
+
+  if (!r || !n_music || !offsets || !targets) return ERROR;
+
+  m = (r->num_relations > 0) ? r->num_relations : 1;
+  off = (int *)malloc(sizeof(int) * (r->num_music + 1));
+  tgt = (int *)malloc(sizeof(int) * m);
+  if (weights) wgt = (double *)malloc(sizeof(double) * m);
+  if (!off || !tgt || (weights && !wgt)) {
+    free(off);
+    free(tgt);
+    free(wgt);
+    return ERROR;
+  }
+
+  for (i = 0; i < r->num_music; i++) {
+    off[i] = k;
+    if (r->relations[i].size > 0) {
+      memcpy(&tgt[k], r->relations[i].dest, sizeof(int) * r->relations[i].size);
+    }
+    for (j = 0; wgt && j < r->relations[i].size; j++) {
+      wgt[k + j] = r->relations[i].weight ? r->relations[i].weight[j] : RADIO_DEFAULT_WEIGHT;
+    }
+    k += r->relations[i].size;
+  }
+  off[r->num_music] = k;
+
+  *n_music = r->num_music;
+  *offsets = off;
+  *targets = tgt;
+  if (weights) *weights = wgt;
+
+  return OK;
+}
+
+/**
+ * @brief Builds a compact (CSR) copy of the radio relations and weights.
+ *
+ * @param r Pointer to the radio.
+ * @param n_music Output, number of music in the copy.
+ * @param offsets Output, address where the offsets array is stored.
+ * @param targets Output, address where the targets array is stored.
+ * @param weights Output, address where the weights array is stored, or
+ * NULL if the weights are not needed.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getWeightedAdjacency(const Radio *r, int *n_music, int **offsets, int **targets,
+                                  double **weights) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  radio_readLock(r);
+  st = radio_getWeightedAdjacencyUnlocked(r, n_music, offsets, targets, weights);
+  radio_unlock(r);
+
+  return st;
+}
+
+static int radio_printUnlocked(FILE *pf, const Radio *r) {
   int i, j, chars = 0, written;
 
   if (!pf || !r) return -1;
 
+  for (i = 0; i < r->num_music; i++) {
+    if (radio_loadMusic(r, i) == ERROR) return -1;
+  }
+
   for (i = 0; i < r->num_music; i++) {
     written = music_plain_print(pf, r->songs[i]);
     if (written < 0) return -1;
@@ -329,16 +1685,14 @@ int radio_print(FILE *pf, const Radio *r) {
     if (written < 0) return -1;
     chars += written;
 
-    for (j = 0; j < r->num_music; j++) {
-      if (r->relations[i][j] == TRUE) {
-        written = fprintf(pf, " ");
-        if (written < 0) return -1;
-        chars += written;
+    for (j = 0; j < r->relations[i].size; j++) {
+      written = fprintf(pf, " ");
+      if (written < 0) return -1;
+      chars += written;
 
-        written = music_plain_print(pf, r->songs[j]);
-        if (written < 0) return -1;
-        chars += written;
-      }
+      written = music_plain_print(pf, r->songs[r->relations[i].dest[j]]);
+      if (written < 0) return -1;
+      chars += written;
     }
 
     written = fprintf(pf, "\n");
@@ -350,21 +1704,35 @@ int radio_print(FILE *pf, const Radio *r) {
 }
 
 /**
- * @brief Reads a radio definition from a text file.
+ * @brief Prints a radio.
  *
- * Reads a radio description from the text file pointed to by fin,
- * and fills the radio r.
+ * Prints the radio g to the file pf.
+ * The format to be followed is: print a line by music with the
+ * information associated with the music and then their connections
  *
- * @param fin Pointer to the input stream.
+ * @param pf File descriptor.
  * @param r Pointer to the radio.
  *
- * @return OK or ERROR
+ * @return The number of characters printed, or -1 if there is any error.
  */
-Status radio_readFromFile(FILE *fin, Radio *r) {
+int radio_print(FILE *pf, const Radio *r) {
+  int ret;
+
+  if (!r) return -1;
+
+  radio_readLock(r);
+  ret = radio_printUnlocked(pf, r);
+  radio_unlock(r);
+
+  return ret;
+}
+
+static Status radio_readFile(FILE *fin, Radio *r) {
   char line[RADIO_LINE_SIZE];
-  char *token;
+  char *token, *colon;
   long number_of_music, orig, dest;
   int i;
+  Status st = OK;
 
   if (!fin || !r) return ERROR;
 
@@ -375,46 +1743,71 @@ Status radio_readFromFile(FILE *fin, Radio *r) {
   for (i = 0; i < number_of_music; i++) {
     if (!fgets(line, sizeof(line), fin)) return ERROR;
     line[strcspn(line, "\r\n")] = '\0';
-    if (radio_newMusic(r, line) == ERROR) return ERROR;
+    trace_begin("radio_newMusic");
+    st = radio_newMusic(r, line);
+    trace_end("radio_newMusic");
+    if (st == ERROR) return ERROR;
   }
 
   while (fgets(line, sizeof(line), fin)) {
     token = strtok(line, " \t\r\n");
     if (!token) continue;
 
+    /* Every line is traced as one batch of relations */
+    trace_begin("radio_newRelations");
     orig = atol(token);
     token = strtok(NULL, " \t\r\n");
-    while (token) {
+    while (st == OK && token) {
       dest = atol(token);
-      if (radio_newRelation(r, orig, dest) == ERROR) return ERROR;
+      colon = strchr(token, ':');
+      if (colon) {
+        st = radio_newWeightedRelation(r, orig, dest, atof(colon + 1));
+      } else {
+        st = radio_newRelation(r, orig, dest);
+      }
       token = strtok(NULL, " \t\r\n");
     }
+    trace_end("radio_newRelations");
+    if (st == ERROR) return ERROR;
   }
 
   return OK;
 }
 
 /**
- * @brief Makes a depth-first search from one music to another.
+ * @brief Reads a radio definition from a text file.
  *
- * The function prints each visited music while traversing the radio.
+ * Reads a radio description from the text file pointed to by fin,
+ * and fills the radio r.
  *
- * @param r Pointer to radio.
- * @param from_id ID of the origin Music.
- * @param to_id ID of the destination Music.
+ * @param fin Pointer to the input stream.
+ * @param r Pointer to the radio.
  *
- * @return The function returns OK or ERROR.
+ * @return OK or ERROR
  */
-Status radio_depthSearch(Radio *r, long from_id, long to_id) {
+Status radio_readFromFile(FILE *fin, Radio *r) {
+  Status st;
+
+  trace_begin("radio_readFromFile");
+  perf_begin(PERF_RADIO_LOAD);
+  st = radio_readFile(fin, r);
+  perf_end(PERF_RADIO_LOAD);
+  trace_end("radio_readFromFile");
+
+  return st;
+}
+
+static Status radio_depthSearchUnlocked(FILE *pf, Radio *r, long from_id, long to_id) {
   Stack *s;
+  Status st;
   Music *origin;
-  Music *target;
   Music *current;
   Music *next;
   int i_from;
   int i_to;
   int i;
   int row;
+  RadioScratch *scratch = NULL;
 
   if (!r) return ERROR;
 
@@ -422,60 +1815,68 @@ Status radio_depthSearch(Radio *r, long from_id, long to_id) {
   i_to = radio_getIndexById(r, to_id);
   if (i_from < 0 || i_to < 0) return ERROR;
 
-  if (radio_resetMusicStates(r) == ERROR) return ERROR;
+  /* Concurrent searches cannot share the music states */
+  if (r->concurrent == TRUE) {
+    scratch = radio_getScratch(r->num_music);
+    if (!scratch) return ERROR;
+  } else if (radio_resetMusicStates(r) == ERROR) {
+    return ERROR;
+  }
+  if (radio_findComponent(r, i_from) != radio_findComponent(r, i_to)) {
+    return radio_searchUnreachable(pf, r, scratch, i_from);
+  }
+
+  /* Only the traversal is measured, not the lock wait nor the setup */
+  if (scratch) {
+    perf_begin(PERF_DEPTH_SEARCH);
+    st = radio_scratchSearch(pf, r, scratch, i_from, i_to, TRUE);
+    perf_end(PERF_DEPTH_SEARCH);
+    return st;
+  }
 
   s = stack_init();
   if (!s) return ERROR;
 
+  perf_begin(PERF_DEPTH_SEARCH);
+  radio_visit(r, scratch, i_from);
   origin = r->songs[i_from];
-  target = r->songs[i_to];
-  if (music_setState(origin, LISTENED) == ERROR || stack_push(s, origin) == ERROR) {
-    stack_free(s);
-    return ERROR;
-  }
+  st = stack_push(s, origin);
 
-  while (stack_isEmpty(s) == FALSE) {
+  while (st == OK && stack_isEmpty(s) == FALSE) {
     current = (Music *)stack_pop(s);
     if (!current) {
-      stack_free(s);
-      return ERROR;
+      st = ERROR;
+      break;
     }
 
-    if (music_plain_print(stdout, current) < 0 || fprintf(stdout, "\n") < 0) {
-      stack_free(s);
-      return ERROR;
+    if (radio_printVisited(pf, current, scratch) < 0) {
+      st = ERROR;
+      break;
     }
 
-    if (music_getId(current) == music_getId(target)) {
-      stack_free(s);
-      return OK;
-    }
+    if (music_getIndex(current) == i_to) break;
 
     row = music_getIndex(current);
     if (row < 0 || row >= r->num_music) {
-      stack_free(s);
-      return ERROR;
+      st = ERROR;
+      break;
     }
 
-    for (i = 0; i < r->num_music; i++) {
-      if (r->relations[row][i] == FALSE) continue;
-
-      next = r->songs[i];
-      if (music_getState(next) == NOT_LISTENED) {
-        if (music_setState(next, LISTENED) == ERROR || stack_push(s, next) == ERROR) {
-          stack_free(s);
-          return ERROR;
-        }
+    for (i = 0; st == OK && i < r->relations[row].size; i++) {
+      if (radio_visit(r, scratch, r->relations[row].dest[i]) == TRUE) {
+        next = r->songs[r->relations[row].dest[i]];
+        st = stack_push(s, next);
       }
     }
   }
+  perf_end(PERF_DEPTH_SEARCH);
 
   stack_free(s);
-  return OK;
+  return st;
 }
 
 /**
- * @brief Makes a breadth-first search from one music to another.
+ * @brief Makes a depth-first search from one music to another.
  *
  * The function prints each visited music while traversing the radio.
  *
@@ -484,26 +1885,59 @@ Status radio_depthSearch(Radio *r, long from_id, long to_id) {
  * @param to_id ID of the destination Music.
  *
  * @return The function returns OK or ERROR.
+ */
+Status radio_depthSearch(Radio *r, long from_id, long to_id) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  trace_begin("radio_depthSearch");
+  radio_readLock(r);
+  st = radio_depthSearchUnlocked(stdout, r, from_id, to_id);
+  radio_unlock(r);
+  trace_end("radio_depthSearch");
+
+  return st;
+}
+
+/**
+ * @brief Makes a depth-first search from one music to another, printing to a
+ * file.
  *
- * Question 1:
- * DFS explores one branch as deep as possible before backtracking, while BFS
- * explores the radio level by level from the origin music.
+ * Same as radio_depthSearch, but the visited music are printed to pf.
  *
- * Question 2:
- * DFS works well in problems such as maze exploration or topological traversal
- * of dependency graphs. BFS works well in problems such as shortest path in an
- * unweighted graph or minimum-number-of-hops recommendation systems.
+ * @param pf File descriptor.
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ *
+ * @return The function returns OK or ERROR.
  */
-Status radio_breadthSearch(Radio *r, long from_id, long to_id) {
+Status radio_printDepthSearch(FILE *pf, Radio *r, long from_id, long to_id) {
+  Status st;
+
+  if (!pf || !r) return ERROR;
+
+  trace_begin("radio_depthSearch");
+  radio_readLock(r);
+  st = radio_depthSearchUnlocked(pf, r, from_id, to_id);
+  radio_unlock(r);
+  trace_end("radio_depthSearch");
+
+  return st;
+}
+
+static Status radio_breadthSearchUnlocked(FILE *pf, Radio *r, long from_id, long to_id) {
   Queue *q;
+  Status st;
   Music *origin;
-  Music *target;
   Music *current;
   Music *next;
   int i_from;
   int i_to;
   int i;
   int row;
+  RadioScratch *scratch = NULL;
 
   if (!r) return ERROR;
 
@@ -511,61 +1945,545 @@ Status radio_breadthSearch(Radio *r, long from_id, long to_id) {
   i_to = radio_getIndexById(r, to_id);
   if (i_from < 0 || i_to < 0) return ERROR;
 
-  if (radio_resetMusicStates(r) == ERROR) return ERROR;
+  /* Concurrent searches cannot share the music states */
+  if (r->concurrent == TRUE) {
+    scratch = radio_getScratch(r->num_music);
+    if (!scratch) return ERROR;
+  } else if (radio_resetMusicStates(r) == ERROR) {
+    return ERROR;
+  }
+  if (radio_findComponent(r, i_from) != radio_findComponent(r, i_to)) {
+    return radio_searchUnreachable(pf, r, scratch, i_from);
+  }
+
+  /* Only the traversal is measured, not the lock wait nor the setup */
+  if (scratch) {
+    perf_begin(PERF_BREADTH_SEARCH);
+    st = radio_scratchSearch(pf, r, scratch, i_from, i_to, FALSE);
+    perf_end(PERF_BREADTH_SEARCH);
+    return st;
+  }
 
   q = queue_new();
   if (!q) return ERROR;
 
+  perf_begin(PERF_BREADTH_SEARCH);
+  radio_visit(r, scratch, i_from);
   origin = r->songs[i_from];
-  target = r->songs[i_to];
-  if (music_setState(origin, LISTENED) == ERROR || queue_push(q, origin) == ERROR) {
-    queue_free(q);
-    return ERROR;
-  }
+  st = queue_push(q, origin);
 
-  while (queue_isEmpty(q) == FALSE) {
+  while (st == OK && queue_isEmpty(q) == FALSE) {
     current = (Music *)queue_pop(q);
     if (!current) {
-      queue_free(q);
-      return ERROR;
+      st = ERROR;
+      break;
     }
 
-    if (music_plain_print(stdout, current) < 0 || fprintf(stdout, "\n") < 0) {
-      queue_free(q);
-      return ERROR;
+    if (radio_printVisited(pf, current, scratch) < 0) {
+      st = ERROR;
+      break;
     }
 
-    if (music_getId(current) == music_getId(target)) {
-      queue_free(q);
-      return OK;
-    }
+    if (music_getIndex(current) == i_to) break;
 
     row = music_getIndex(current);
     if (row < 0 || row >= r->num_music) {
-      queue_free(q);
-      return ERROR;
+      st = ERROR;
+      break;
     }
 
-    for (i = 0; i < r->num_music; i++) {
-      if (r->relations[row][i] == FALSE) continue;
-
-      next = r->songs[i];
-      if (music_getState(next) == NOT_LISTENED) {
-        if (music_setState(next, LISTENED) == ERROR || queue_push(q, next) == ERROR) {
-          queue_free(q);
-          return ERROR;
-        }
+    for (i = 0; st == OK && i < r->relations[row].size; i++) {
+      if (radio_visit(r, scratch, r->relations[row].dest[i]) == TRUE) {
+        next = r->songs[r->relations[row].dest[i]];
+        st = queue_push(q, next);
       }
     }
   }
+  perf_end(PERF_BREADTH_SEARCH);
 
   queue_free(q);
+  return st;
+}
+
+/**
+ * @brief Makes a breadth-first search from one music to another.
+ *
+ * The function prints each visited music while traversing the radio.
+ *
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ *
+ * @return The function returns OK or ERROR.
+ *
+ * Question 1:
+ * DFS explores one branch as deep as possible before backtracking, while BFS
+ * explores the radio level by level from the origin music.
+ *
+ * Question 2:
+ * DFS works well in problems such as maze exploration or topological traversal
+ * of dependency graphs. BFS works well in problems such as shortest path in an
+ * unweighted graph or minimum-number-of-hops recommendation systems.
+ */
+Status radio_breadthSearch(Radio *r, long from_id, long to_id) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  trace_begin("radio_breadthSearch");
+  radio_readLock(r);
+  st = radio_breadthSearchUnlocked(stdout, r, from_id, to_id);
+  radio_unlock(r);
+  trace_end("radio_breadthSearch");
+
+  return st;
+}
+
+/**
+ * @brief Makes a breadth-first search from one music to another, printing to a
+ * file.
+ *
+ * Same as radio_breadthSearch, but the visited music are printed to pf.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ *
+ * @return The function returns OK or ERROR.
+ */
+Status radio_printBreadthSearch(FILE *pf, Radio *r, long from_id, long to_id) {
+  Status st;
+
+  if (!pf || !r) return ERROR;
+
+  trace_begin("radio_breadthSearch");
+  radio_readLock(r);
+  st = radio_breadthSearchUnlocked(pf, r, from_id, to_id);
+  radio_unlock(r);
+  trace_end("radio_breadthSearch");
+
+  return st;
+}
+
+static long *radio_shortestPathUnlocked(const Radio *r, long from_id, long to_id,
+                                        RadioWeight weight, int *n_path, double *cost) {
+  Heap *h;
+  double *dist;
+  int *prev;
+  long *path = NULL;
+  const Relations *rel;
+  double d, nd, step;
+  int i_from, i_to, v, k, len;
+  Status st;
+
+  if (!r || !n_path) return NULL;
+  *n_path = 0;
+
+  i_from = radio_getIndexById(r, from_id);
+  i_to = radio_getIndexById(r, to_id);
+  if (i_from < 0 || i_to < 0) return NULL;
+
+  h = heap_new(r->num_music);
+  dist = (double *)malloc(sizeof(double) * r->num_music);
+  prev = (int *)malloc(sizeof(int) * r->num_music);
+  if (!h || !dist || !prev) {
+    heap_free(h);
+    free(dist);
+    free(prev);
+    return NULL;
+  }
+
+  for (v = 0; v < r->num_music; v++) {
+    dist[v] = -1;
+    prev[v] = -1;
+  }
+
+  dist[i_from] = 0;
+  st = heap_push(h, i_from, 0);
+
+  while (st == OK && heap_isEmpty(h) == FALSE) {
+    v = heap_pop(h, &d);
+    if (v == i_to) break;
+
+    rel = &r->relations[v];
+    for (k = 0; k < rel->size; k++) {
+      step = radio_transitionCost(r, rel, k, weight);
+      if (step < 0) {
+        st = ERROR;
+        break;
+      }
+      nd = d + step;
+      if (dist[rel->dest[k]] < 0 || nd < dist[rel->dest[k]]) {
+        /* Settled music always keep dist <= nd, so they are never pushed again */
+        dist[rel->dest[k]] = nd;
+        prev[rel->dest[k]] = v;
+        st = heap_push(h, rel->dest[k], nd);
+        if (st == ERROR) break;
+      }
+    }
+  }
+
+  if (st == OK && dist[i_to] >= 0 && heap_contains(h, i_to) == FALSE) {
+    len = 0;
+    for (v = i_to; v >= 0; v = prev[v]) len++;
+
+    path = (long *)malloc(sizeof(long) * len);
+    if (path) {
+      *n_path = len;
+      for (v = i_to; v >= 0; v = prev[v]) path[--len] = r->ids[v];
+      if (cost) *cost = dist[i_to];
+    }
+  }
+
+  heap_free(h);
+  free(dist);
+  free(prev);
+
+  return path;
+}
+
+/**
+ * @brief Finds the cheapest sequence of relations from one music to another.
+ *
+ * Runs Dijkstra's algorithm with an indexed binary heap, stopping as soon
+ * as the destination music is extracted.
+ *
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ * @param weight Cost of every relation.
+ * @param n_path Output, number of ids of the path (0 if to_id cannot be
+ * reached from from_id).
+ * @param cost Output, total cost of the path (can be NULL).
+ *
+ * @return An array with the ids of the music of the path, or NULL if
+ * there is any error or no path.
+ */
+long *radio_shortestPath(const Radio *r, long from_id, long to_id, RadioWeight weight,
+                         int *n_path, double *cost) {
+  long *ret;
+
+  if (!r) return NULL;
+
+  radio_readLock(r);
+  ret = radio_shortestPathUnlocked(r, from_id, to_id, weight, n_path, cost);
+  radio_unlock(r);
+
+  return ret;
+}
+
+/**
+ * @brief Sorts the music so that every relation goes forward.
+ *
+ * Runs Kahn's algorithm over the in-degrees of the music, without
+ * recursion, in O(music + relations). Music with no relations reaching
+ * them come first, in the order of their positions.
+ *
+ * This function allocates memory for the array.
+ *
+ * @param r Pointer to radio.
+ * @param n_order Output, number of music that could be ordered: all of
+ * them if the radio is acyclic, fewer otherwise.
+ *
+ * @return An array with the positions of all the music in topological
+ * order, or NULL if there is any error or the radio has a cycle.
+ */
+int *radio_topologicalOrder(const Radio *r, int *n_order) {
+  int *order;
+  int n = -1;
+
+  if (!r || !n_order) return NULL;
+  *n_order = 0;
+
+  radio_readLock(r);
+  order = (int *)malloc(sizeof(int) * (r->num_music > 0 ? r->num_music : 1));
+  if (order) n = radio_kahn(r, order);
+  if (n >= 0) *n_order = n;
+  if (n < r->num_music) {
+    free(order);
+    order = NULL;
+  }
+  radio_unlock(r);
+
+  return order;
+}
+
+/**
+ * @brief Checks if the relations of a radio form a cycle.
+ *
+ * Uses the same in-degree count as radio_topologicalOrder, so it runs in
+ * O(music + relations) instead of searching from every music.
+ *
+ * @param r Pointer to radio.
+ *
+ * @return TRUE if some music can be reached again by following its
+ * relations, FALSE if the radio is acyclic or there is any error.
+ */
+Bool radio_hasCycle(const Radio *r) {
+  int *order;
+  int n = -1;
+
+  if (!r) return FALSE;
+
+  radio_readLock(r);
+  order = (int *)malloc(sizeof(int) * (r->num_music > 0 ? r->num_music : 1));
+  if (order) n = radio_kahn(r, order);
+  radio_unlock(r);
+
+  free(order);
+
+  return (n >= 0 && n < r->num_music) ? TRUE : FALSE;
+}
+
+/**
+ * @brief Chooses the landmarks of a radio and stores the hops from and to
+ * each of them.
+ *
+ * Runs two breadth-first searches per landmark, one following the
+ * relations and one against them. Each music keeps one byte per landmark
+ * and direction, saturated at 254 hops. Adding a music or a relation
+ * drops the landmarks.
+ *
+ * @param r Pointer to radio.
+ * @param k Number of landmarks, from 0 (drops them) to
+ * RADIO_MAX_LANDMARKS; fewer if the radio has less music.
+ * @param method How the landmarks are chosen.
+ * @param seed Seed of the random choice (ignored by RADIO_LANDMARK_DEGREE).
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setLandmarks(Radio *r, int k, RadioLandmark method, unsigned int seed) {
+  int *queue = NULL, *dist = NULL, *degree = NULL;
+  int i, j, l, best;
+  Status st = OK;
+
+  if (!r || k < 0 || k > RADIO_MAX_LANDMARKS) return ERROR;
+
+  radio_writeLock(r);
+  radio_dropLandmarks(r);
+  if (k > r->num_music) k = r->num_music;
+  if (k == 0) {
+    radio_unlock(r);
+    return OK;
+  }
+
+  r->hops_from = (unsigned char *)malloc((size_t)k * r->num_music);
+  r->hops_to = (unsigned char *)malloc((size_t)k * r->num_music);
+  queue = (int *)malloc(sizeof(int) * r->num_music);
+  dist = (int *)malloc(sizeof(int) * r->num_music);
+  degree = (int *)malloc(sizeof(int) * r->num_music);
+  if (!r->hops_from || !r->hops_to || !queue || !dist || !degree) st = ERROR;
+
+  if (st == OK && method == RADIO_LANDMARK_DEGREE) {
+    /* The k music with most relations in either direction; chosen ones get -1 */
+    for (i = 0; i < r->num_music; i++) degree[i] = r->relations[i].size + r->incoming[i].size;
+    for (l = 0; l < k; l++) {
+      for (i = 1, best = 0; i < r->num_music; i++) {
+        if (degree[i] > degree[best]) best = i;
+      }
+      r->landmarks[l] = best;
+      degree[best] = -1;
+    }
+  } else if (st == OK) {
+    /* The first k positions of a partial Fisher-Yates shuffle */
+    for (i = 0; i < r->num_music; i++) degree[i] = i;
+    for (l = 0; l < k; l++) {
+      j = l + rand_r(&seed) % (r->num_music - l);
+      r->landmarks[l] = degree[j];
+      degree[j] = degree[l];
+    }
+  }
+
+  if (st == OK) {
+    r->num_landmarks = k;
+    for (l = 0; l < k; l++) {
+      radio_landmarkSearch(r, r->landmarks[l], FALSE, r->hops_from + l, queue, dist);
+      radio_landmarkSearch(r, r->landmarks[l], TRUE, r->hops_to + l, queue, dist);
+    }
+  } else {
+    radio_dropLandmarks(r);
+  }
+  radio_unlock(r);
+
+  free(queue);
+  free(dist);
+  free(degree);
+
+  return st;
+}
+
+static int radio_estimateDistanceUnlocked(const Radio *r, long from_id, long to_id,
+                                          int max_error) {
+  int a, b, lower, upper = -1;
+
+  a = radio_getIndexById(r, from_id);
+  b = radio_getIndexById(r, to_id);
+  if (a < 0 || b < 0 || max_error < 0) return -1;
+
+  if (a == b) return 0;
+  if (radio_findComponent(r, a) != radio_findComponent(r, b)) return -1;
+
+  if (r->num_landmarks > 0) {
+    if (radio_landmarkBounds(r, a, b, &lower, &upper) == FALSE) return -1;
+    if (upper >= 0 && upper - lower <= max_error) return upper;
+  }
+
+  return radio_hopDistance(r, a, b, upper);
+}
+
+/**
+ * @brief Estimates the number of relations of the shortest path between
+ * two music.
+ *
+ * The landmarks give a lower and an upper bound by the triangle
+ * inequality. If they differ by at most max_error, the upper bound is
+ * returned without searching; otherwise the exact distance is found with
+ * a bidirectional breadth-first search, which stops early once only the
+ * upper bound is left. Without landmarks it always searches.
+ *
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ * @param max_error Largest error accepted (0 always gives the exact
+ * distance).
+ *
+ * @return A distance between the exact one and the exact one plus
+ * max_error, or -1 if there is no path or there is any error.
+ */
+int radio_estimateDistance(const Radio *r, long from_id, long to_id, int max_error) {
+  int d;
+
+  if (!r) return -1;
+
+  radio_readLock(r);
+  d = radio_estimateDistanceUnlocked(r, from_id, to_id, max_error);
+  radio_unlock(r);
+
+  return d;
+}
+
+static Status radio_getStatsUnlocked(const Radio *r, RadioStats *stats) {
+  const Relations *out, *in;
+  int *histogram;
+  int i, d, seen, p50, p90, p99;
+
+  if (!r || !stats) return ERROR;
+
+  histogram = (int *)calloc(r->num_music + 1, sizeof(int));
+  if (!histogram) return ERROR;
+
+  memset(stats, 0, sizeof(RadioStats));
+  stats->radio_bytes = sizeof(Radio);
+  stats->name_bytes = r->names_capacity;
+  stats->num_music = r->num_music;
+  stats->num_relations = r->num_relations;
+  stats->min_degree = (r->num_music > 0) ? r->relations[0].size : 0;
+
+  for (i = 0; i < r->num_music; i++) {
+    out = &r->relations[i];
+    in = &r->incoming[i];
+
+    stats->music_bytes += music_getMemorySize(r->songs[i]);
+    stats->relation_bytes += sizeof(int) * out->capacity;
+    stats->incoming_bytes += sizeof(int) * in->capacity;
+    if (out->weight) stats->weight_bytes += sizeof(double) * out->capacity;
+
+    if (out->size == 0 && in->size == 0) stats->num_isolated++;
+    if (out->size < stats->min_degree) stats->min_degree = out->size;
+    if (out->size > stats->max_degree) stats->max_degree = out->size;
+    histogram[out->size]++;
+  }
+
+  /* radio_shortestPath: heap (item, key, position), distances and predecessors */
+  stats->workspace_bytes = (size_t)r->num_music * (3 * sizeof(int) + 2 * sizeof(double));
+  stats->landmark_bytes = 2 * (size_t)r->num_landmarks * r->num_music;
+  stats->total_bytes = stats->radio_bytes + stats->name_bytes + stats->music_bytes +
+                       stats->relation_bytes + stats->incoming_bytes + stats->weight_bytes +
+                       stats->landmark_bytes + stats->workspace_bytes;
+
+  if (r->num_music > 0) {
+    stats->mean_degree = (double)r->num_relations / r->num_music;
+
+    /* Nearest rank: the smallest degree covering ceil(p * n) music */
+    p50 = (r->num_music * 50 + 99) / 100;
+    p90 = (r->num_music * 90 + 99) / 100;
+    p99 = (r->num_music * 99 + 99) / 100;
+    for (d = 0, seen = 0; d <= stats->max_degree; d++) {
+      if (seen < p50 && seen + histogram[d] >= p50) stats->p50_degree = d;
+      if (seen < p90 && seen + histogram[d] >= p90) stats->p90_degree = d;
+      if (seen < p99 && seen + histogram[d] >= p99) stats->p99_degree = d;
+      seen += histogram[d];
+    }
+  }
+
+  free(histogram);
+
   return OK;
 }
 
+/**
+ * @brief Computes the memory footprint and degree statistics of a radio.
+ *
+ * All the values are gathered in a single pass over the music; the
+ * percentiles come from a histogram of the degrees.
+ *
+ * @param r Pointer to radio.
+ * @param stats Output, statistics of the radio.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getStats(const Radio *r, RadioStats *stats) {
+  Status st;
+
+  if (!r) return ERROR;
+
+  radio_readLock(r);
+  st = radio_getStatsUnlocked(r, stats);
+  radio_unlock(r);
+
+  return st;
+}
+
+/**
+ * @brief Prints the statistics of a radio.
+ *
+ * @param pf File descriptor.
+ * @param stats Statistics returned by radio_getStats.
+ *
+ * @return The number of characters printed, or -1 if there is any error.
+ */
+int radio_printStats(FILE *pf, const RadioStats *stats) {
+  int count = 0, ret;
+
+  if (!pf || !stats) return -1;
+
+  ret = fprintf(pf, "Music: %d\nRelations: %d\nIsolated music: %d\n", stats->num_music,
+                stats->num_relations, stats->num_isolated);
+  if (ret < 0) return -1;
+  count += ret;
+
+  ret = fprintf(pf, "Degree: min %d, max %d, mean %.2f, p50 %d, p90 %d, p99 %d\n",
+                stats->min_degree, stats->max_degree, stats->mean_degree, stats->p50_degree,
+                stats->p90_degree, stats->p99_degree);
+  if (ret < 0) return -1;
+  count += ret;
+
+  ret = fprintf(pf,
+                "Memory (bytes):\n  radio %zu\n  names %zu\n  music %zu\n  relations %zu\n"
+                "  incoming %zu\n  weights %zu\n  landmarks %zu\n  search workspace %zu\n"
+                "  total %zu\n",
+                stats->radio_bytes, stats->name_bytes, stats->music_bytes,
+                stats->relation_bytes, stats->incoming_bytes, stats->weight_bytes,
+                stats->landmark_bytes, stats->workspace_bytes, stats->total_bytes);
+  if (ret < 0) return -1;
+  count += ret;
+
+  return count;
+}
 
 Music **radio_getSongs(Radio *r) {
-  if (!r) return NULL;
+  if (!r || radio_loadAll(r) == ERROR) return NULL;
 
   return r->songs;
 }
@@ -577,10 +2495,9 @@ int _radio_findmusicById(const Radio *r, long id) {
     return -1;
   }
 
-  for (i = 0; i < r->num_music; i++) {
-    if (music_getId(r->songs[i]) == id) {
-      return i;
-    }
-  }
-  return -1;
+  radio_readLock(r);
+  i = radio_getIndexById(r, id);
+  radio_unlock(r);
+
+  return i;
 }
@@ -15,6 +15,67 @@
 
 typedef struct _Radio Radio;
 
+/**
+ * @brief Weight of the relations created without an explicit weight.
+ */
+#define RADIO_DEFAULT_WEIGHT 1.0
+
+/**
+ * @brief Cost of moving through a relation in weighted searches.
+ */
+typedef enum {
+    RADIO_RELATION_WEIGHT, /*!< The weight stored in the relation */
+    RADIO_DURATION_WEIGHT  /*!< The duration of the destination music */
+} RadioWeight;
+
+/**
+ * @brief Similarity measures for radio_similarSongs.
+ */
+typedef enum {
+    RADIO_JACCARD,     /*!< Common relations divided by the relations of both */
+    RADIO_ADAMIC_ADAR  /*!< Sum of 1/log(degree) of the common neighbours */
+} RadioSimilarity;
+
+/**
+ * @brief Largest number of landmarks of radio_setLandmarks.
+ */
+#define RADIO_MAX_LANDMARKS 64
+
+/**
+ * @brief How radio_setLandmarks chooses the landmarks.
+ */
+typedef enum {
+    RADIO_LANDMARK_DEGREE, /*!< The music with most relations */
+    RADIO_LANDMARK_RANDOM  /*!< Music chosen at random */
+} RadioLandmark;
+
+/**
+ * @brief Memory footprint and degree distribution of a radio.
+ *
+ * The degree of a music is its number of outgoing relations. Percentiles
+ * are nearest-rank values over all the music.
+ */
+typedef struct {
+    size_t radio_bytes;      /*!< Fixed size of the radio structure */
+    size_t name_bytes;       /*!< Capacity of the pool of titles and artists */
+    size_t music_bytes;      /*!< Memory of the music handles */
+    size_t relation_bytes;   /*!< Capacity of the outgoing relation lists */
+    size_t incoming_bytes;   /*!< Capacity of the incoming relation lists */
+    size_t weight_bytes;     /*!< Capacity of the relation weights */
+    size_t landmark_bytes;   /*!< Hops from and to the landmarks */
+    size_t workspace_bytes;  /*!< Largest temporary memory of a search */
+    size_t total_bytes;      /*!< Sum of all the above */
+    int num_music;           /*!< Number of music */
+    int num_relations;       /*!< Number of relations */
+    int num_isolated;        /*!< Music without incoming or outgoing relations */
+    int min_degree;          /*!< Smallest degree */
+    int max_degree;          /*!< Largest degree */
+    double mean_degree;      /*!< Average degree */
+    int p50_degree;          /*!< Median degree */
+    int p90_degree;          /*!< 90th percentile of the degree */
+    int p99_degree;          /*!< 99th percentile of the degree */
+} RadioStats;
+
 /**
  * @brief Creates a new empty radio.
  *
@@ -35,6 +96,47 @@ Radio * radio_init();
  **/
 void radio_free(Radio *r);
 
+/**
+ * @brief Turns the concurrent mode of a radio on or off.
+ *
+ * In concurrent mode the functions that add music or relations take a
+ * write lock and all the queries take a read lock, so any number of
+ * threads can query the radio while others modify it. Searches mark the
+ * visited music in a scratch area of the calling thread instead of
+ * changing the state of the music, and print them as LISTENED, as the
+ * searches of the sequential mode do.
+ *
+ * Turning it on loads the music added in lazy mode, and music added while
+ * it is on are always loaded at once.
+ *
+ * Must be called while no other thread uses the radio.
+ *
+ * @param r Pointer to radio.
+ * @param concurrent TRUE to turn the concurrent mode on, FALSE otherwise.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setConcurrent(Radio *r, Bool concurrent);
+
+/**
+ * @brief Turns the lazy mode of a radio on or off.
+ *
+ * In lazy mode radio_newMusic only reads the id and the state of the
+ * music and keeps its description; the music is parsed the first time
+ * its handle, title, artist or duration is needed. A description that
+ * cannot be parsed then makes that access fail. Turning the lazy mode
+ * off loads all the music that are still pending.
+ *
+ * Jobs that only touch a few music of a big radio should turn it on
+ * before radio_readFromFile.
+ *
+ * @param r Pointer to radio.
+ * @param lazy TRUE to turn the lazy mode on, FALSE otherwise.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setLazy(Radio *r, Bool lazy);
+
 /**
  * @brief Inserts a new music in a radio.
  *
@@ -64,6 +166,22 @@ Status radio_newMusic(Radio *r, char *desc);
  **/
 Status radio_newRelation(Radio *r, long orig, long dest);
 
+/**
+ * @brief Creates (or updates) a weighted relation between two music.
+ *
+ * Works like radio_newRelation, but the relation gets the given weight.
+ * If the relation already exists only its weight is updated. Relations
+ * created with radio_newRelation have weight RADIO_DEFAULT_WEIGHT.
+ *
+ * @param r Pointer to the radio.
+ * @param orig ID of the origin music.
+ * @param dest ID of the destination music.
+ * @param weight Weight of the relation, greater or equal than 0.
+ *
+ * @return OK if the relation could be added or updated, ERROR otherwise.
+ **/
+Status radio_newWeightedRelation(Radio *r, long orig, long dest, double weight);
+
 /**
  * @brief Checks if a radio contains a music.
  *
@@ -107,6 +225,17 @@ int radio_getNumberOfRelations(const Radio *r);
  **/
 Bool radio_relationExists(const Radio *r, long orig, long dest);
 
+/**
+ * @brief Returns the weight of the relation between a pair of music.
+ *
+ * @param r Pointer to the radio.
+ * @param orig ID of the origin music.
+ * @param dest ID of the destination music.
+ *
+ * @return The weight of the relation, or -1 if there is no such relation.
+ **/
+double radio_getRelationWeight(const Radio *r, long orig, long dest);
+
 /**
  * @brief Gets the number of relations starting at a given music.
  *
@@ -132,9 +261,73 @@ int radio_getNumberOfRelationsFromId(const Radio *r, long id);
  */
 long *radio_getRelationsFromId(const Radio *r, long id);
 
+/**
+ * @brief Checks if two music are in the same weakly connected component.
+ *
+ * The components are kept with a union-find structure updated by every
+ * new relation, so the check costs O(log n) at most and does not traverse
+ * the radio.
+ *
+ * @param r Pointer to the radio.
+ * @param a ID of one music.
+ * @param b ID of the other music.
+ *
+ * @return TRUE if a and b are connected ignoring the direction of the
+ * relations, FALSE otherwise (or if any of them is not in the radio).
+ */
+Bool radio_sameComponent(const Radio *r, long a, long b);
+
+/**
+ * @brief Returns the number of weakly connected components of a radio.
+ *
+ * @param r Pointer to the radio.
+ *
+ * @return The number of components, or -1 if there is any error.
+ */
+int radio_getNumberOfComponents(const Radio *r);
+
+/**
+ * @brief Returns the size of the weakly connected component of a music.
+ *
+ * @param r Pointer to the radio.
+ * @param id ID of the music.
+ *
+ * @return The number of music in its component, or -1 if there is any
+ * error.
+ */
+int radio_getComponentSize(const Radio *r, long id);
+
+/**
+ * @brief Finds the music most similar to a given one.
+ *
+ * Two music are similar when they share destinations (outgoing relations)
+ * and origins (incoming relations). The candidates are the music at two
+ * relations of distance; for each one the common neighbours are found by
+ * intersecting the sorted relation lists (see intersect.h).
+ *
+ * This function allocates memory for the array.
+ *
+ * @param r Pointer to the radio.
+ * @param id ID of the music.
+ * @param k Maximum number of similar music to return.
+ * @param sim Similarity measure.
+ * @param scores Output array with k positions for the similarity of each
+ * returned music (can be NULL).
+ * @param n_similar Output, number of ids returned.
+ *
+ * @return An array with the ids of the most similar music, by decreasing
+ * similarity, or NULL if there is any error or no similar music.
+ */
+long *radio_similarSongs(const Radio *r, long id, int k, RadioSimilarity sim, double *scores,
+                         int *n_similar);
+
 /**
  * @brief Returns the Music stored at a given position of the radio.
  *
+ * The id, title, artist and duration of the music are also kept by the
+ * radio in contiguous arrays, so they must not be modified through the
+ * returned handle.
+ *
  * @param r Pointer to the radio.
  * @param index Position of the song in the radio.
  *
@@ -143,6 +336,97 @@ long *radio_getRelationsFromId(const Radio *r, long id);
  */
 Music *radio_getMusicAt(const Radio *r, int index);
 
+/**
+ * @brief Returns the id of the music at a given position of the radio.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The id of the music, or -1 if there is any error.
+ */
+long radio_getIdAt(const Radio *r, int index);
+
+/**
+ * @brief Returns the duration of the music at a given position of the radio.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The duration of the music, or (unsigned short)-1 if there is any
+ * error.
+ */
+unsigned short radio_getDurationAt(const Radio *r, int index);
+
+/**
+ * @brief Returns the title of the music at a given position of the radio.
+ *
+ * The string lives in a pool of the radio and is valid until the next
+ * music is added. In concurrent mode another thread can add one at any
+ * time, so there the title must be taken from the handle returned by
+ * radio_getMusicAt, which keeps its own copy.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The title of the music, or NULL if there is any error.
+ */
+const char *radio_getTitleAt(const Radio *r, int index);
+
+/**
+ * @brief Returns the artist of the music at a given position of the radio.
+ *
+ * The string lives in a pool of the radio and is valid until the next
+ * music is added. In concurrent mode another thread can add one at any
+ * time, so there the artist must be taken from the handle returned by
+ * radio_getMusicAt, which keeps its own copy.
+ *
+ * @param r Pointer to the radio.
+ * @param index Position of the song in the radio.
+ *
+ * @return The artist of the music, or NULL if there is any error.
+ */
+const char *radio_getArtistAt(const Radio *r, int index);
+
+/**
+ * @brief Builds a compact (CSR) copy of the radio relations.
+ *
+ * The relations are returned indexed by song position: the destinations
+ * of the song at position i are targets[offsets[i]] .. targets[offsets[i+1]-1],
+ * in increasing position order. offsets has n_music + 1 entries and
+ * targets has offsets[n_music] entries. The number of music is read under
+ * the same lock as the relations, so it matches the arrays even if other
+ * threads are adding songs; size any buffer from it, not from
+ * radio_getNumberOfMusic.
+ *
+ * This function allocates memory for both arrays; the caller frees them.
+ *
+ * @param r Pointer to the radio.
+ * @param n_music Output, number of music in the copy.
+ * @param offsets Output, address where the offsets array is stored.
+ * @param targets Output, address where the targets array is stored.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getAdjacency(const Radio *r, int *n_music, int **offsets, int **targets);
+
+/**
+ * @brief Builds a compact (CSR) copy of the radio relations and weights.
+ *
+ * Same as radio_getAdjacency, and weights (if not NULL) receives an array
+ * with the weight of every relation, aligned with targets.
+ *
+ * @param r Pointer to the radio.
+ * @param n_music Output, number of music in the copy.
+ * @param offsets Output, address where the offsets array is stored.
+ * @param targets Output, address where the targets array is stored.
+ * @param weights Output, address where the weights array is stored, or
+ * NULL if the weights are not needed.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getWeightedAdjacency(const Radio *r, int *n_music, int **offsets, int **targets,
+                                  double **weights);
+
 
 /**
  * @brief Prints a radio.
@@ -175,7 +459,8 @@ int radio_print (FILE *pf, const Radio *r);
  * The first line in the file contains the number of music.
  * Then one line per music with the music description.  
  * Finally one line per relation, with the ids of the origin and 
- * the destination (this is one way only)
+ * the destination (this is one way only). A destination written as
+ * id:weight creates a weighted relation (see radio_newWeightedRelation).
  *
  * For example:
  *
@@ -200,6 +485,8 @@ Status radio_readFromFile (FILE *fin, Radio *r);
  * @brief Makes a depth-first search from one music to another.
  *
  * The function prints each visited music while traversing the radio.
+ * If the destination is in another weakly connected component (see
+ * radio_sameComponent) only the origin music is visited.
  *
  * @param r Pointer to radio.
  * @param from_id ID of the origin Music.
@@ -209,10 +496,27 @@ Status radio_readFromFile (FILE *fin, Radio *r);
  */
 Status radio_depthSearch(Radio *r, long from_id, long to_id);
 
+/**
+ * @brief Makes a depth-first search from one music to another, printing to a
+ * file.
+ *
+ * Same as radio_depthSearch, but the visited music are printed to pf.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ *
+ * @return The function returns OK or ERROR.
+ */
+Status radio_printDepthSearch(FILE *pf, Radio *r, long from_id, long to_id);
+
 /**
  * @brief Makes a breadth-first search from one music to another.
  *
  * The function prints each visited music while traversing the radio.
+ * If the destination is in another weakly connected component (see
+ * radio_sameComponent) only the origin music is visited.
  *
  * @param r Pointer to radio.
  * @param from_id ID of the origin Music.
@@ -231,6 +535,139 @@ Status radio_depthSearch(Radio *r, long from_id, long to_id);
  */
 Status radio_breadthSearch(Radio *r, long from_id, long to_id);
 
+/**
+ * @brief Makes a breadth-first search from one music to another, printing to a
+ * file.
+ *
+ * Same as radio_breadthSearch, but the visited music are printed to pf.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ *
+ * @return The function returns OK or ERROR.
+ */
+Status radio_printBreadthSearch(FILE *pf, Radio *r, long from_id, long to_id);
+
+/**
+ * @brief Finds the cheapest sequence of relations from one music to another.
+ *
+ * Runs Dijkstra's algorithm (with a binary heap) from from_id, stopping
+ * as soon as to_id is reached. The cost of each relation is its weight
+ * (RADIO_RELATION_WEIGHT) or the duration of its destination music
+ * (RADIO_DURATION_WEIGHT).
+ *
+ * This function allocates memory for the array.
+ *
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ * @param weight Cost of every relation.
+ * @param n_path Output, number of ids of the path (0 if to_id cannot be
+ * reached from from_id).
+ * @param cost Output, total cost of the path (can be NULL).
+ *
+ * @return An array with the ids of the music of the path, from from_id
+ * to to_id, or NULL if there is any error or no path.
+ */
+long *radio_shortestPath(const Radio *r, long from_id, long to_id, RadioWeight weight,
+                         int *n_path, double *cost);
+
+/**
+ * @brief Sorts the music so that every relation goes forward.
+ *
+ * Runs Kahn's algorithm over the in-degrees of the music, without
+ * recursion, in O(music + relations). Music with no relations reaching
+ * them come first, in the order of their positions.
+ *
+ * This function allocates memory for the array.
+ *
+ * @param r Pointer to radio.
+ * @param n_order Output, number of music that could be ordered: all of
+ * them if the radio is acyclic, fewer otherwise.
+ *
+ * @return An array with the positions of all the music in topological
+ * order, or NULL if there is any error or the radio has a cycle.
+ */
+int *radio_topologicalOrder(const Radio *r, int *n_order);
+
+/**
+ * @brief Checks if the relations of a radio form a cycle.
+ *
+ * Uses the same in-degree count as radio_topologicalOrder, so it runs in
+ * O(music + relations) instead of searching from every music.
+ *
+ * @param r Pointer to radio.
+ *
+ * @return TRUE if some music can be reached again by following its
+ * relations, FALSE if the radio is acyclic or there is any error.
+ */
+Bool radio_hasCycle(const Radio *r);
+
+/**
+ * @brief Chooses the landmarks of a radio and stores the hops from and to
+ * each of them.
+ *
+ * Runs two breadth-first searches per landmark, one following the
+ * relations and one against them. Each music keeps one byte per landmark
+ * and direction, saturated at 254 hops. Adding a music or a relation
+ * drops the landmarks.
+ *
+ * @param r Pointer to radio.
+ * @param k Number of landmarks, from 0 (drops them) to
+ * RADIO_MAX_LANDMARKS; fewer if the radio has less music.
+ * @param method How the landmarks are chosen.
+ * @param seed Seed of the random choice (ignored by RADIO_LANDMARK_DEGREE).
+ *
+ * @return OK or ERROR.
+ */
+Status radio_setLandmarks(Radio *r, int k, RadioLandmark method, unsigned int seed);
+
+/**
+ * @brief Estimates the number of relations of the shortest path between
+ * two music.
+ *
+ * The landmarks give a lower and an upper bound by the triangle
+ * inequality. If they differ by at most max_error, the upper bound is
+ * returned without searching; otherwise the exact distance is found with
+ * a bidirectional breadth-first search, which stops early once only the
+ * upper bound is left. Without landmarks it always searches.
+ *
+ * @param r Pointer to radio.
+ * @param from_id ID of the origin Music.
+ * @param to_id ID of the destination Music.
+ * @param max_error Largest error accepted (0 always gives the exact
+ * distance).
+ *
+ * @return A distance between the exact one and the exact one plus
+ * max_error, or -1 if there is no path or there is any error.
+ */
+int radio_estimateDistance(const Radio *r, long from_id, long to_id, int max_error);
+
+/**
+ * @brief Computes the memory footprint and degree statistics of a radio.
+ *
+ * All the values are gathered in a single pass over the music; the
+ * percentiles come from a histogram of the degrees.
+ *
+ * @param r Pointer to radio.
+ * @param stats Output, statistics of the radio.
+ *
+ * @return OK or ERROR.
+ */
+Status radio_getStats(const Radio *r, RadioStats *stats);
+
+/**
+ * @brief Prints the statistics of a radio.
+ *
+ * @param pf File descriptor.
+ * @param stats Statistics returned by radio_getStats.
+ *
+ * @return The number of characters printed, or -1 if there is any error.
+ */
+int radio_printStats(FILE *pf, const RadioStats *stats);
+
 Music **radio_getSongs(Radio *r);
 
 
@@ -0,0 +1,359 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstree.h"
+#include "list.h"
+#include "queue.h"
+#include "radio.h"
+#include "stack.h"
+
+#define BENCH_REPS 50
+#define BENCH_WARMUP 5
+#define BENCH_RANGE_FRACTION 10   /* A range search covers 1/10 of the songs */
+
+typedef struct _BenchData {
+  const char *path;   /* Radio file */
+  Radio *radio;       /* Radio of the searches and the containers */
+  Radio *loaded;      /* Radio of the last load */
+  FILE *sink;         /* Output of the searches */
+  Music **songs;      /* Music in a random order */
+  Music **sorted;     /* Music by increasing id */
+  int n;
+  BSTree *tree;       /* Tree with all the music, for the lookups */
+  BSTree *scratch;    /* Tree being built */
+  Stack *stack;
+  Queue *queue;
+  List *list;
+  long from_id;       /* Music of the next search */
+  long to_id;
+  int first;          /* Position in sorted of the next range */
+  unsigned int seed;
+  long ops;           /* Operations made by the last repetition */
+} BenchData;
+
+/* prepare and cleanup run before and after every repetition and are not timed */
+typedef struct _BenchCase {
+  const char *name;
+  Status (*prepare)(BenchData *d);
+  Status (*run)(BenchData *d);
+  void (*cleanup)(BenchData *d);
+} BenchCase;
+
+static double nowNanos(void) {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+static int compareMusic(const void *a, const void *b) {
+  return music_cmp(*(Music *const *)a, *(Music *const *)b);
+}
+
+static Status runLoad(BenchData *d) {
+  FILE *pf;
+  Status st;
+
+  pf = fopen(d->path, "r");
+  if (!pf) return ERROR;
+  d->loaded = radio_init();
+  st = (d->loaded) ? radio_readFromFile(pf, d->loaded) : ERROR;
+  fclose(pf);
+  d->ops = 1;
+
+  return st;
+}
+
+static void cleanupLoad(BenchData *d) {
+  radio_free(d->loaded);
+  d->loaded = NULL;
+}
+
+static Status prepareSearch(BenchData *d) {
+  d->from_id = music_getId(d->songs[rand_r(&d->seed) % d->n]);
+  d->to_id = music_getId(d->songs[rand_r(&d->seed) % d->n]);
+
+  return OK;
+}
+
+static Status runDepthSearch(BenchData *d) {
+  d->ops = 1;
+
+  return radio_printDepthSearch(d->sink, d->radio, d->from_id, d->to_id);
+}
+
+static Status runBreadthSearch(BenchData *d) {
+  d->ops = 1;
+
+  return radio_printBreadthSearch(d->sink, d->radio, d->from_id, d->to_id);
+}
+
+static Status prepareInsert(BenchData *d) {
+  d->scratch = tree_init(music_plain_print, music_cmp);
+
+  return (d->scratch) ? OK : ERROR;
+}
+
+static Status runInsert(BenchData *d) {
+  int i;
+
+  for (i = 0; i < d->n; i++) {
+    if (tree_insert(d->scratch, d->songs[i]) == ERROR) return ERROR;
+  }
+  d->ops = d->n;
+
+  return OK;
+}
+
+static void cleanupInsert(BenchData *d) {
+  tree_destroy(d->scratch);
+  d->scratch = NULL;
+}
+
+static Status runContains(BenchData *d) {
+  int i;
+
+  for (i = 0; i < d->n; i++) {
+    if (tree_contains(d->tree, d->songs[i]) == FALSE) return ERROR;
+  }
+  d->ops = d->n;
+
+  return OK;
+}
+
+static Status prepareRange(BenchData *d) {
+  d->first = rand_r(&d->seed) % (d->n - d->n / BENCH_RANGE_FRACTION);
+
+  return OK;
+}
+
+static Status runRange(BenchData *d) {
+  List *l;
+
+  l = tree_rangeSearch(d->tree, d->sorted[d->first],
+                       d->sorted[d->first + d->n / BENCH_RANGE_FRACTION]);
+  if (!l) return ERROR;
+  list_free(l);
+  d->ops = 1;
+
+  return OK;
+}
+
+static Status prepareStack(BenchData *d) {
+  d->stack = stack_init();
+
+  return (d->stack) ? OK : ERROR;
+}
+
+static Status runStack(BenchData *d) {
+  int i;
+
+  for (i = 0; i < d->n; i++) {
+    if (stack_push(d->stack, d->songs[i]) == ERROR) return ERROR;
+  }
+  for (i = 0; i < d->n; i++) {
+    if (!stack_pop(d->stack)) return ERROR;
+  }
+  d->ops = 2L * d->n;
+
+  return OK;
+}
+
+static void cleanupStack(BenchData *d) {
+  stack_free(d->stack);
+  d->stack = NULL;
+}
+
+static Status prepareQueue(BenchData *d) {
+  d->queue = queue_new();
+
+  return (d->queue) ? OK : ERROR;
+}
+
+static Status runQueue(BenchData *d) {
+  int i;
+
+  for (i = 0; i < d->n; i++) {
+    if (queue_push(d->queue, d->songs[i]) == ERROR) return ERROR;
+  }
+  for (i = 0; i < d->n; i++) {
+    if (!queue_pop(d->queue)) return ERROR;
+  }
+  d->ops = 2L * d->n;
+
+  return OK;
+}
+
+static void cleanupQueue(BenchData *d) {
+  queue_free(d->queue);
+  d->queue = NULL;
+}
+
+static Status prepareList(BenchData *d) {
+  d->list = list_new();
+
+  return (d->list) ? OK : ERROR;
+}
+
+static Status runList(BenchData *d) {
+  int i;
+
+  for (i = 0; i < d->n; i++) {
+    if (list_pushBack(d->list, d->songs[i]) == ERROR) return ERROR;
+  }
+  for (i = 0; i < d->n; i++) {
+    if (!list_popFront(d->list)) return ERROR;
+  }
+  d->ops = 2L * d->n;
+
+  return OK;
+}
+
+static void cleanupList(BenchData *d) {
+  list_free(d->list);
+  d->list = NULL;
+}
+
+static const BenchCase cases[] = {
+    {"radio_readFromFile", NULL, runLoad, cleanupLoad},
+    {"radio_depthSearch", prepareSearch, runDepthSearch, NULL},
+    {"radio_breadthSearch", prepareSearch, runBreadthSearch, NULL},
+    {"tree_insert", prepareInsert, runInsert, cleanupInsert},
+    {"tree_contains", NULL, runContains, NULL},
+    {"tree_rangeSearch", prepareRange, runRange, NULL},
+    {"stack_push_pop", prepareStack, runStack, cleanupStack},
+    {"queue_push_pop", prepareQueue, runQueue, cleanupQueue},
+    {"list_push_pop", prepareList, runList, cleanupList},
+};
+
+/* Prints one JSON object per line with the times of the repetitions */
+static Status runCase(const BenchCase *c, BenchData *d, int reps, int warmup, double *samples) {
+  double start, sum = 0;
+  int i;
+  Status st = OK;
+
+  for (i = 0; st == OK && i < warmup + reps; i++) {
+    if (c->prepare) st = c->prepare(d);
+    if (st == ERROR) break;
+    start = nowNanos();
+    st = c->run(d);
+    if (i >= warmup) samples[i - warmup] = nowNanos() - start;
+    if (c->cleanup) c->cleanup(d);
+  }
+  if (st == ERROR) {
+    fprintf(stderr, "Error: %s failed\n", c->name);
+    return ERROR;
+  }
+
+  for (i = 0; i < reps; i++) sum += samples[i];
+  qsort(samples, reps, sizeof(double), compareDoubles);
+
+  printf("{\"bench\": \"%s\", \"songs\": %d, \"ops\": %ld, \"reps\": %d, "
+         "\"min_ns\": %.0f, \"median_ns\": %.0f, \"p99_ns\": %.0f, \"mean_ns\": %.0f, "
+         "\"ns_per_op\": %.2f}\n",
+         c->name, d->n, d->ops, reps, samples[0], samples[reps / 2],
+         samples[(int)ceil(0.99 * reps) - 1], sum / reps, samples[reps / 2] / d->ops);
+
+  return OK;
+}
+
+static void freeData(BenchData *d) {
+  tree_destroy(d->tree);
+  free(d->songs);
+  free(d->sorted);
+  if (d->sink) fclose(d->sink);
+  radio_free(d->radio);
+}
+
+static Status loadData(BenchData *d) {
+  FILE *pf;
+  Music *tmp;
+  int i, j;
+  Status st;
+
+  pf = fopen(d->path, "r");
+  if (!pf) return ERROR;
+  d->radio = radio_init();
+  st = (d->radio) ? radio_readFromFile(pf, d->radio) : ERROR;
+  fclose(pf);
+  if (st == ERROR) return ERROR;
+
+  d->n = radio_getNumberOfMusic(d->radio);
+  if (d->n <= 0) return ERROR;
+
+  d->sink = fopen("/dev/null", "w");
+  d->songs = (Music **)malloc(sizeof(Music *) * d->n);
+  d->sorted = (Music **)malloc(sizeof(Music *) * d->n);
+  d->tree = tree_init(music_plain_print, music_cmp);
+  if (!d->sink || !d->songs || !d->sorted || !d->tree) return ERROR;
+
+  for (i = 0; i < d->n; i++) {
+    d->songs[i] = radio_getMusicAt(d->radio, i);
+    if (!d->songs[i]) return ERROR;
+  }
+  /* The trees are built in a random order, so they are not degenerate */
+  for (i = d->n - 1; i > 0; i--) {
+    j = rand_r(&d->seed) % (i + 1);
+    tmp = d->songs[i];
+    d->songs[i] = d->songs[j];
+    d->songs[j] = tmp;
+  }
+  memcpy(d->sorted, d->songs, sizeof(Music *) * d->n);
+  qsort(d->sorted, d->n, sizeof(Music *), compareMusic);
+
+  for (i = 0; i < d->n; i++) {
+    if (tree_insert(d->tree, d->songs[i]) == ERROR) return ERROR;
+  }
+
+  return OK;
+}
+
+int main(int argc, char **argv) {
+  BenchData d;
+  double *samples;
+  int i, reps, warmup;
+  Status st = OK;
+
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "Usage: %s <radio_file> [reps] [warmup]\n", argv[0]);
+    fprintf(stderr, "Prints one JSON object per benchmark with its times in nanoseconds\n");
+    return EXIT_FAILURE;
+  }
+
+  reps = (argc > 2) ? atoi(argv[2]) : BENCH_REPS;
+  warmup = (argc > 3) ? atoi(argv[3]) : BENCH_WARMUP;
+  if (reps <= 0 || warmup < 0) {
+    fprintf(stderr, "Error: invalid number of repetitions\n");
+    return EXIT_FAILURE;
+  }
+
+  memset(&d, 0, sizeof(BenchData));
+  d.path = argv[1];
+  d.seed = 1;
+  samples = (double *)malloc(sizeof(double) * reps);
+  if (!samples || loadData(&d) == ERROR) {
+    fprintf(stderr, "Error: could not load %s\n", argv[1]);
+    free(samples);
+    freeData(&d);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; st == OK && i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+    st = runCase(&cases[i], &d, reps, warmup, samples);
+  }
+
+  free(samples);
+  freeData(&d);
+
+  return (st == OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
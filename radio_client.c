@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "protocol.h"
+
+/* Sends a request and prints its answer; returns 0 if it was PROTOCOL_OK, 1 if it was an
+ * error and -1 if the connection was lost */
+static int request(FILE *in, FILE *out, const char *line) {
+  char answer[PROTOCOL_LINE_SIZE];
+  size_t ok_len = strlen(PROTOCOL_OK), err_len = strlen(PROTOCOL_ERR);
+
+  if (fprintf(out, "%s\n", line) < 0 || fflush(out) != 0) return -1;
+
+  while (fgets(answer, sizeof(answer), in)) {
+    if (strncmp(answer, PROTOCOL_OK, ok_len) == 0 &&
+        (answer[ok_len] == '\n' || answer[ok_len] == '\0')) {
+      return 0;
+    }
+    if (strncmp(answer, PROTOCOL_ERR, err_len) == 0 && answer[err_len] == ' ') {
+      fprintf(stderr, "Error: %s", answer + err_len + 1);
+      return 1;
+    }
+    fputs(answer, stdout);
+  }
+
+  return -1;
+}
+
+int main(int argc, char **argv) {
+  struct sockaddr_un addr;
+  FILE *in, *out;
+  char line[PROTOCOL_LINE_SIZE];
+  size_t len = 0;
+  int fd, out_fd, i, st = 0, failed = 0;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <socket_path> [command args...]\n", argv[0]);
+    fprintf(stderr, "Without a command, reads one request per line from stdin\n");
+    return EXIT_FAILURE;
+  }
+  if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Error: socket path too long\n");
+    return EXIT_FAILURE;
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, argv[1]);
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("Error: could not connect to the server");
+    if (fd >= 0) close(fd);
+    return EXIT_FAILURE;
+  }
+
+  out_fd = dup(fd);
+  in = fdopen(fd, "r");
+  out = (out_fd >= 0) ? fdopen(out_fd, "w") : NULL;
+  if (!in || !out) {
+    fprintf(stderr, "Error: could not open the connection\n");
+    if (in) {
+      fclose(in);
+    } else {
+      close(fd);
+    }
+    if (out) {
+      fclose(out);
+    } else if (out_fd >= 0) {
+      close(out_fd);
+    }
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 2) {
+    /* The command is given in the arguments */
+    line[0] = '\0';
+    for (i = 2; i < argc; i++) {
+      if (len + strlen(argv[i]) + 2 > sizeof(line)) {
+        fprintf(stderr, "Error: request too long\n");
+        fclose(in);
+        fclose(out);
+        return EXIT_FAILURE;
+      }
+      if (i > 2) line[len++] = ' ';
+      strcpy(line + len, argv[i]);
+      len += strlen(argv[i]);
+    }
+    st = request(in, out, line);
+    failed = (st != 0);
+  } else {
+    while (fgets(line, sizeof(line), stdin)) {
+      line[strcspn(line, "\r\n")] = '\0';
+      if (line[0] == '\0') continue;
+      st = request(in, out, line);
+      if (st != 0) failed = 1;
+      if (st < 0) break;
+    }
+  }
+
+  if (st < 0) fprintf(stderr, "Error: connection closed by the server\n");
+
+  fclose(out);
+  fclose(in);
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
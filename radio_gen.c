@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+
+#define GEN_LINE_RELATIONS 256   /* Destinations per line, well under RADIO_LINE_SIZE */
+#define GEN_MIN_DURATION 120
+#define GEN_MAX_DURATION 420
+#define GEN_SONGS_PER_ARTIST 10
+
+typedef enum { GEN_UNIFORM, GEN_POWERLAW } GenDegree;
+typedef enum { GEN_SORTED, GEN_RANDOM, GEN_ADVERSARIAL } GenOrder;
+
+static const char *gen_first[] = {"Golden", "Broken", "Electric", "Midnight", "Wild",
+                                  "Silent", "Burning", "Endless", "Lonely", "Sweet",
+                                  "Neon", "Crystal", "Summer", "Velvet", "Paper", "Hidden"};
+static const char *gen_second[] = {"Heart", "River", "Dreams", "Highway", "Fire", "Rain",
+                                   "Lights", "Sky", "Road", "Love", "Night", "Ocean",
+                                   "Shadows", "Echo", "Thunder", "Stars"};
+
+static unsigned long long rng;   /* xorshift64* state */
+
+static unsigned long long genRand(void) {
+  rng ^= rng >> 12;
+  rng ^= rng << 25;
+  rng ^= rng >> 27;
+
+  return rng * 2685821657736338717ULL;
+}
+
+/* Uniform integer in [0, n) by multiply-shift */
+static long genRandInt(long n) {
+  return (long)(((genRand() >> 32) * (unsigned long long)n) >> 32);
+}
+
+/* Uniform double in (0, 1] */
+static double genRandDouble(void) {
+  return ((genRand() >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/* Zipf-like rank in [0, n) with probability about 1 / (rank + 1) */
+static long genZipf(long n) {
+  long k = (long)exp(genRandDouble() * log((double)n + 1)) - 1;
+
+  return (k < n) ? k : n - 1;
+}
+
+static long genDegree(GenDegree degree, double mean, long n) {
+  long d;
+
+  if (mean <= 0) return 0;
+
+  if (degree == GEN_UNIFORM) {
+    d = genRandInt((long)(2 * mean) + 1);
+  } else {
+    /* Pareto with exponent 2 has mean 2 * x_min */
+    d = (long)(mean / 2 / sqrt(genRandDouble()) + 0.5);
+  }
+
+  return (d < n) ? d : n - 1;
+}
+
+static int compareLongs(const void *a, const void *b) {
+  long x = *(const long *)a, y = *(const long *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void genShuffle(long *v, long n) {
+  long i, j, tmp;
+
+  for (i = n - 1; i > 0; i--) {
+    j = genRandInt(i + 1);
+    tmp = v[i];
+    v[i] = v[j];
+    v[j] = tmp;
+  }
+}
+
+/*
+ * Id of the music at every position. The adversarial order alternates the
+ * lowest and highest ids left, so every insertion in a plain binary search
+ * tree goes below the last one although the input is not sorted.
+ */
+static void genIds(long *ids, long n, GenOrder order) {
+  long i, low = 1, high = n;
+
+  for (i = 0; i < n; i++) {
+    if (order == GEN_ADVERSARIAL) {
+      ids[i] = (i % 2 == 0) ? low++ : high--;
+    } else {
+      ids[i] = i + 1;
+    }
+  }
+  if (order == GEN_RANDOM) genShuffle(ids, n);
+}
+
+static Status genWriteMusic(FILE *pf, const long *ids, long n) {
+  long i;
+
+  for (i = 0; i < n; i++) {
+    if (fprintf(pf, "id:\"%ld\" title:\"%s %s\" artist:\"Artist %ld\" duration:\"%ld\"\n",
+                ids[i], gen_first[genRandInt(16)], gen_second[genRandInt(16)],
+                genZipf(n / GEN_SONGS_PER_ARTIST + 1) + 1,
+                GEN_MIN_DURATION + genRandInt(GEN_MAX_DURATION - GEN_MIN_DURATION + 1)) < 0) {
+      return ERROR;
+    }
+  }
+
+  return OK;
+}
+
+/*
+ * Writes the relations of every music. Power-law radios also pick their
+ * destinations with a Zipf law over a random popularity order, so a few
+ * songs get most of the incoming relations.
+ */
+static Status genWriteRelations(FILE *pf, const long *ids, long n, double mean,
+                                GenDegree degree) {
+  long *popular = NULL, *dest;
+  long i, k, d, count;
+
+  dest = (long *)malloc(sizeof(long) * (n > 0 ? n : 1));
+  if (degree == GEN_POWERLAW) popular = (long *)malloc(sizeof(long) * (n > 0 ? n : 1));
+  if (!dest || (degree == GEN_POWERLAW && !popular)) {
+    free(dest);
+    free(popular);
+    return ERROR;
+  }
+  if (popular) {
+    for (i = 0; i < n; i++) popular[i] = i;
+    genShuffle(popular, n);
+  }
+
+  for (i = 0; i < n; i++) {
+    d = genDegree(degree, mean, n);
+    for (k = 0, count = 0; k < d; k++) {
+      dest[count] = (degree == GEN_POWERLAW) ? popular[genZipf(n)] : genRandInt(n);
+      if (dest[count] != i) count++;
+    }
+    qsort(dest, count, sizeof(long), compareLongs);
+
+    for (k = 0, d = 0; k < count; k++) {
+      if (k > 0 && dest[k] == dest[k - 1]) continue;
+      if (d % GEN_LINE_RELATIONS == 0) {
+        if (d > 0 && fprintf(pf, "\n") < 0) break;
+        if (fprintf(pf, "%ld", ids[i]) < 0) break;
+      }
+      if (fprintf(pf, " %ld", ids[dest[k]]) < 0) break;
+      d++;
+    }
+    if (k < count || (d > 0 && fprintf(pf, "\n") < 0)) break;
+  }
+
+  free(dest);
+  free(popular);
+
+  return (i < n) ? ERROR : OK;
+}
+
+int main(int argc, char **argv) {
+  long *ids;
+  long n;
+  double mean = 0;
+  GenDegree degree = GEN_UNIFORM;
+  GenOrder order = GEN_SORTED;
+  Status st;
+
+  if (argc < 2 || argc > 6) {
+    fprintf(stderr, "Usage: %s <n_songs> [mean_degree] [uniform|powerlaw] "
+            "[sorted|random|adversarial] [seed]\n", argv[0]);
+    fprintf(stderr, "Writes a radio to stdout; with mean_degree 0 (default) a music catalog\n");
+    return EXIT_FAILURE;
+  }
+
+  n = atol(argv[1]);
+  if (argc > 2) mean = atof(argv[2]);
+  if (argc > 3 && strcmp(argv[3], "powerlaw") == 0) degree = GEN_POWERLAW;
+  if (argc > 3 && strcmp(argv[3], "uniform") != 0 && degree != GEN_POWERLAW) {
+    fprintf(stderr, "Error: unknown degree distribution %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  if (argc > 4 && strcmp(argv[4], "random") == 0) order = GEN_RANDOM;
+  if (argc > 4 && strcmp(argv[4], "adversarial") == 0) order = GEN_ADVERSARIAL;
+  if (argc > 4 && strcmp(argv[4], "sorted") != 0 && order == GEN_SORTED) {
+    fprintf(stderr, "Error: unknown id order %s\n", argv[4]);
+    return EXIT_FAILURE;
+  }
+  rng = (argc > 5) ? strtoull(argv[5], NULL, 10) : 1;
+  /* xorshift gets stuck at 0, so the seed goes through the splitmix64 finalizer */
+  rng = (rng ^ (rng >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  rng = (rng ^ (rng >> 27)) * 0x94d049bb133111ebULL;
+  rng ^= rng >> 31;
+  if (rng == 0) rng = 1;
+
+  if (n <= 0 || !(mean >= 0)) {
+    fprintf(stderr, "Error: invalid number of songs or mean degree\n");
+    return EXIT_FAILURE;
+  }
+
+  ids = (long *)malloc(sizeof(long) * n);
+  if (!ids) {
+    fprintf(stderr, "Error: not enough memory for %ld songs\n", n);
+    return EXIT_FAILURE;
+  }
+  genIds(ids, n, order);
+
+  st = (printf("%ld\n", n) < 0) ? ERROR : OK;
+  if (st == OK) st = genWriteMusic(stdout, ids, n);
+  if (st == OK && mean > 0) st = genWriteRelations(stdout, ids, n, mean, degree);
+  if (st == OK && fflush(stdout) != 0) st = ERROR;
+
+  free(ids);
+
+  if (st == ERROR) {
+    fprintf(stderr, "Error: could not write the radio\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,329 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "protocol.h"
+#include "radio.h"
+#include "trace.h"
+
+#define SERVER_MAX_CLIENTS 64
+#define SERVER_BACKLOG 16
+
+typedef struct {
+  Radio *radio;
+  int fds[SERVER_MAX_CLIENTS];   /* Sockets of the connected clients, -1 if free */
+  int n_clients;
+  pthread_mutex_t mutex;
+  pthread_cond_t done;           /* Signaled when a client leaves */
+} Server;
+
+typedef struct {
+  Server *server;
+  int slot;
+  int fd;
+} Client;
+
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int sig) {
+  (void)sig;
+  stop = 1;
+}
+
+static Status printMusicById(FILE *out, const Radio *r, long id) {
+  if (music_plain_print(out, radio_getMusicAt(r, _radio_findmusicById(r, id))) < 0) return ERROR;
+  if (fprintf(out, "\n") < 0) return ERROR;
+
+  return OK;
+}
+
+/* Answers one request; returns FALSE if the client asked to leave */
+static Bool answer(FILE *out, Radio *r, char *line) {
+  RadioStats stats;
+  char *save = NULL, *cmd, *args[3];
+  long *path;
+  double cost = 0;
+  long a, b;
+  int i, n, n_args = 0;
+  const char *error = NULL;
+
+  cmd = strtok_r(line, " \t\r\n", &save);
+  if (!cmd) return TRUE;
+  while (n_args < 3 && (args[n_args] = strtok_r(NULL, " \t\r\n", &save)) != NULL) n_args++;
+
+  a = (n_args > 0) ? atol(args[0]) : 0;
+  b = (n_args > 1) ? atol(args[1]) : 0;
+
+  if (strcmp(cmd, "QUIT") == 0) {
+    fprintf(out, "%s\n", PROTOCOL_OK);
+    fflush(out);
+    return FALSE;
+  } else if (strcmp(cmd, "CONTAINS") == 0) {
+    if (n_args < 1) {
+      error = "CONTAINS needs an id";
+    } else {
+      fprintf(out, "%d\n", radio_contains(r, a) == TRUE ? 1 : 0);
+    }
+  } else if (strcmp(cmd, "DFS") == 0 || strcmp(cmd, "BFS") == 0) {
+    if (n_args < 2) {
+      error = "searches need two ids";
+    } else if (radio_contains(r, a) == FALSE || radio_contains(r, b) == FALSE) {
+      error = "unknown music";
+    } else if ((cmd[0] == 'D' ? radio_printDepthSearch(out, r, a, b)
+                              : radio_printBreadthSearch(out, r, a, b)) == ERROR) {
+      error = "search failed";
+    }
+  } else if (strcmp(cmd, "PATH") == 0) {
+    if (n_args < 2) {
+      error = "PATH needs two ids";
+    } else {
+      path = radio_shortestPath(r, a, b,
+                                (n_args > 2 && strcmp(args[2], "duration") == 0)
+                                    ? RADIO_DURATION_WEIGHT
+                                    : RADIO_RELATION_WEIGHT,
+                                &n, &cost);
+      if (!path) {
+        error = "no path";
+      } else {
+        for (i = 0; i < n; i++) printMusicById(out, r, path[i]);
+        fprintf(out, "cost %g\n", cost);
+        free(path);
+      }
+    }
+  } else if (strcmp(cmd, "RANGE") == 0) {
+    if (n_args < 2) {
+      error = "RANGE needs two durations";
+    } else {
+      /* Sequential sweep over the durations of the radio */
+      n = radio_getNumberOfMusic(r);
+      for (i = 0; i < n; i++) {
+        if (radio_getDurationAt(r, i) >= a && radio_getDurationAt(r, i) <= b) {
+          music_plain_print(out, radio_getMusicAt(r, i));
+          fprintf(out, "\n");
+        }
+      }
+    }
+  } else if (strcmp(cmd, "STATS") == 0) {
+    if (radio_getStats(r, &stats) == ERROR || radio_printStats(out, &stats) < 0) {
+      error = "could not compute the statistics";
+    }
+  } else {
+    error = "unknown command";
+  }
+
+  if (error) {
+    fprintf(out, "%s %s\n", PROTOCOL_ERR, error);
+  } else {
+    fprintf(out, "%s\n", PROTOCOL_OK);
+  }
+  fflush(out);
+
+  return TRUE;
+}
+
+static void *serveClient(void *arg) {
+  Client *c = (Client *)arg;
+  Server *s = c->server;
+  FILE *in, *out;
+  char line[PROTOCOL_LINE_SIZE];
+  int fd = c->fd, out_fd, ch;
+  Bool go_on;
+
+  out_fd = dup(fd);
+  in = fdopen(fd, "r");
+  out = (out_fd >= 0) ? fdopen(out_fd, "w") : NULL;
+
+  while (in && out && fgets(line, sizeof(line), in)) {
+    /* The rest of a line that does not fit is skipped, and the line gets one error */
+    if (!strchr(line, '\n') && !feof(in)) {
+      while ((ch = getc(in)) != EOF && ch != '\n') continue;
+      fprintf(out, "%s line too long\n", PROTOCOL_ERR);
+      fflush(out);
+      continue;
+    }
+
+    trace_begin("server_request");
+    go_on = answer(out, s->radio, line);
+    trace_end("server_request");
+    if (go_on == FALSE) break;
+  }
+
+  /* The slot is freed before closing, so shutdown never sees a reused descriptor */
+  pthread_mutex_lock(&s->mutex);
+  s->fds[c->slot] = -1;
+  pthread_mutex_unlock(&s->mutex);
+
+  /* Closing the streams closes both descriptors */
+  if (out) {
+    fclose(out);
+  } else if (out_fd >= 0) {
+    close(out_fd);
+  }
+  if (in) {
+    fclose(in);
+  } else {
+    close(fd);
+  }
+
+  pthread_mutex_lock(&s->mutex);
+  s->n_clients--;
+  pthread_cond_signal(&s->done);
+  pthread_mutex_unlock(&s->mutex);
+
+  free(c);
+  return NULL;
+}
+
+/* Starts a thread for a new client, or rejects it if the server is full */
+static void acceptClient(Server *s, int fd) {
+  pthread_t thread;
+  Client *c;
+  int slot = 0;
+  const char *busy = PROTOCOL_ERR " server busy\n";
+
+  pthread_mutex_lock(&s->mutex);
+  while (slot < SERVER_MAX_CLIENTS && s->fds[slot] >= 0) slot++;
+  c = (slot < SERVER_MAX_CLIENTS) ? (Client *)malloc(sizeof(Client)) : NULL;
+  if (c) {
+    c->server = s;
+    c->slot = slot;
+    c->fd = fd;
+    s->fds[slot] = fd;
+    s->n_clients++;
+    if (pthread_create(&thread, NULL, serveClient, c) == 0) {
+      pthread_detach(thread);
+    } else {
+      s->fds[slot] = -1;
+      s->n_clients--;
+      free(c);
+      c = NULL;
+    }
+  }
+  pthread_mutex_unlock(&s->mutex);
+
+  if (!c) {
+    if (write(fd, busy, strlen(busy)) < 0) perror("write");
+    close(fd);
+  }
+}
+
+int main(int argc, char **argv) {
+  Server server;
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  sigset_t block, unblocked;
+  fd_set ready;
+  FILE *fin;
+  int listen_fd, fd, i;
+
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <radio_file> <socket_path>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (strlen(argv[2]) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Error: socket path too long\n");
+    return EXIT_FAILURE;
+  }
+
+  fin = fopen(argv[1], "r");
+  if (!fin) {
+    fprintf(stderr, "Error: could not open file %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  server.radio = radio_init();
+  if (!server.radio || radio_readFromFile(fin, server.radio) == ERROR ||
+      radio_setConcurrent(server.radio, TRUE) == ERROR) {
+    fprintf(stderr, "Error: could not read radio from file %s\n", argv[1]);
+    fclose(fin);
+    radio_free(server.radio);
+    return EXIT_FAILURE;
+  }
+  fclose(fin);
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, argv[2]);
+  unlink(argv[2]);
+  if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(listen_fd, SERVER_BACKLOG) < 0 || fcntl(listen_fd, F_SETFL, O_NONBLOCK) < 0) {
+    perror("Error: could not listen on the socket");
+    if (listen_fd >= 0) close(listen_fd);
+    radio_free(server.radio);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < SERVER_MAX_CLIENTS; i++) server.fds[i] = -1;
+  server.n_clients = 0;
+  pthread_mutex_init(&server.mutex, NULL);
+  pthread_cond_init(&server.done, NULL);
+
+  /*
+   * SIGINT and SIGTERM are blocked before any client thread starts, so
+   * the threads inherit the mask and only the main thread takes them.
+   * They are only unblocked inside pselect, which cannot miss a signal
+   * sent between the check of stop and the wait.
+   */
+  sigemptyset(&block);
+  sigaddset(&block, SIGINT);
+  sigaddset(&block, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &block, &unblocked);
+  sigdelset(&unblocked, SIGINT);
+  sigdelset(&unblocked, SIGTERM);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = onSignal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stderr, "Serving %d music on %s\n", radio_getNumberOfMusic(server.radio), argv[2]);
+
+  while (!stop) {
+    FD_ZERO(&ready);
+    FD_SET(listen_fd, &ready);
+    if (pselect(listen_fd + 1, &ready, NULL, NULL, NULL, &unblocked) < 0) {
+      if (errno == EINTR) continue;
+      perror("pselect");
+      break;
+    }
+
+    /* The socket does not block, in case the client left before accept */
+    fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED) {
+        continue;
+      }
+      perror("accept");
+      break;
+    }
+    acceptClient(&server, fd);
+  }
+
+  close(listen_fd);
+  unlink(argv[2]);
+
+  /* Wake up the clients blocked reading and wait for all of them */
+  pthread_mutex_lock(&server.mutex);
+  for (i = 0; i < SERVER_MAX_CLIENTS; i++) {
+    if (server.fds[i] >= 0) shutdown(server.fds[i], SHUT_RDWR);
+  }
+  while (server.n_clients > 0) pthread_cond_wait(&server.done, &server.mutex);
+  pthread_mutex_unlock(&server.mutex);
+
+  pthread_mutex_destroy(&server.mutex);
+  pthread_cond_destroy(&server.done);
+  radio_free(server.radio);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,984 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "cluster.h"
+#include "compact.h"
+#include "playlist.h"
+#include "radio.h"
+#include "rank.h"
+#include "reach.h"
+#include "shard.h"
+#include "snapshot.h"
+#include "walk.h"
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s <radio_file> <command> [args]\n", prog);
+  fprintf(stderr, "Commands:\n");
+  fprintf(stderr, "  rank [pagerank|degree|closeness] [n_threads]\n");
+  fprintf(stderr, "  walk <seed_id> <steps> [rng_seed] [window] [relation|uniform|duration]\n");
+  fprintf(stderr, "  path <from_id> <to_id> [relation|duration]\n");
+  fprintf(stderr, "  fill <start_id> <budget_seconds> [k]\n");
+  fprintf(stderr, "  similar <id> [k] [jaccard|adamic-adar]\n");
+  fprintf(stderr, "  clusters [n_threads]\n");
+  fprintf(stderr, "  stats\n");
+  fprintf(stderr, "  shard <n_shards> [hash|locality] [output_prefix]\n");
+  fprintf(stderr, "  snapshot <n_readers> <n_relations> [queries]\n");
+  fprintf(stderr, "  concurrent <max_threads> [queries]\n");
+  fprintf(stderr, "  compress [searches]\n");
+  fprintf(stderr, "  order\n");
+  fprintf(stderr, "  landmarks <k> [degree|random] [queries] [max_error]\n");
+  fprintf(stderr, "  reach <n_threads> [index_file] [queries]\n");
+}
+
+static int cmdRank(Radio *r, int argc, char **argv) {
+  const char *method = (argc > 0) ? argv[0] : "pagerank";
+  double *scores;
+  int n_threads = (argc > 1) ? atoi(argv[1]) : 1;
+  int n, iter = 0;
+  Status st = OK;
+
+  if (n_threads <= 0) {
+    fprintf(stderr, "Error: invalid number of threads\n");
+    return EXIT_FAILURE;
+  }
+
+  n = radio_getNumberOfMusic(r);
+  scores = (double *)malloc(sizeof(double) * (n > 0 ? n : 1));
+  if (!scores) {
+    fprintf(stderr, "Error: could not allocate scores\n");
+    return EXIT_FAILURE;
+  }
+
+  if (strcmp(method, "pagerank") == 0) {
+    iter = rank_pageRank(r, RANK_DAMPING, RANK_TOLERANCE, RANK_MAX_ITER, n_threads, scores);
+    if (iter < 0) st = ERROR;
+  } else if (strcmp(method, "degree") == 0) {
+    st = rank_degree(r, scores);
+  } else if (strcmp(method, "closeness") == 0) {
+    st = rank_closeness(r, n_threads, scores);
+  } else {
+    fprintf(stderr, "Error: unknown rank method %s\n", method);
+    free(scores);
+    return EXIT_FAILURE;
+  }
+
+  if (st == ERROR) {
+    fprintf(stderr, "Error: could not compute %s scores\n", method);
+    free(scores);
+    return EXIT_FAILURE;
+  }
+
+  if (strcmp(method, "pagerank") == 0) fprintf(stderr, "PageRank iterations: %d\n", iter);
+
+  if (rank_print(stdout, r, scores) < 0) {
+    fprintf(stderr, "Error: could not print radio\n");
+    free(scores);
+    return EXIT_FAILURE;
+  }
+
+  free(scores);
+  return EXIT_SUCCESS;
+}
+
+static int cmdWalk(Radio *r, int argc, char **argv) {
+  Walk *w;
+  Music *m;
+  p_walk_weight weight = NULL;
+  long i, steps;
+
+  if (argc < 2) {
+    fprintf(stderr, "Error: walk needs a seed id and a number of steps\n");
+    return EXIT_FAILURE;
+  }
+
+  steps = atol(argv[1]);
+  if (argc > 4 && strcmp(argv[4], "uniform") == 0) weight = walk_uniformWeight;
+  if (argc > 4 && strcmp(argv[4], "duration") == 0) weight = walk_durationWeight;
+
+  w = walk_new(r, atol(argv[0]), (argc > 2) ? strtoul(argv[2], NULL, 10) : 0,
+               (argc > 3) ? atoi(argv[3]) : 0, weight);
+  if (!w) {
+    fprintf(stderr, "Error: could not start a walk from music %s\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < steps; i++) {
+    m = walk_next(w);
+    if (!m || fprintf(stdout, "%ld\n", music_getId(m)) < 0) {
+      fprintf(stderr, "Error: walk stopped at step %ld\n", i);
+      walk_free(w);
+      return EXIT_FAILURE;
+    }
+  }
+
+  walk_free(w);
+  return EXIT_SUCCESS;
+}
+
+static int cmdPath(Radio *r, int argc, char **argv) {
+  RadioWeight weight = RADIO_RELATION_WEIGHT;
+  long *path;
+  double cost = 0;
+  int i, n_path;
+
+  if (argc < 2) {
+    fprintf(stderr, "Error: path needs an origin and a destination id\n");
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 2 && strcmp(argv[2], "duration") == 0) weight = RADIO_DURATION_WEIGHT;
+
+  path = radio_shortestPath(r, atol(argv[0]), atol(argv[1]), weight, &n_path, &cost);
+  if (!path) {
+    if (n_path == 0 && radio_contains(r, atol(argv[0])) && radio_contains(r, atol(argv[1]))) {
+      printf("No path from %s to %s\n", argv[0], argv[1]);
+      return EXIT_SUCCESS;
+    }
+    fprintf(stderr, "Error: could not search a path from %s to %s\n", argv[0], argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  printf("Cost: %g\n", cost);
+  for (i = 0; i < n_path; i++) {
+    music_plain_print(stdout, radio_getMusicAt(r, _radio_findmusicById(r, path[i])));
+    printf("\n");
+  }
+
+  free(path);
+  return EXIT_SUCCESS;
+}
+
+static int cmdFill(Radio *r, int argc, char **argv) {
+  Playlist *best;
+  Bool exact = FALSE;
+  int i, j, k, found;
+
+  if (argc < 2) {
+    fprintf(stderr, "Error: fill needs a start id and a budget\n");
+    return EXIT_FAILURE;
+  }
+
+  k = (argc > 2) ? atoi(argv[2]) : 1;
+  if (k <= 0) {
+    fprintf(stderr, "Error: invalid number of playlists\n");
+    return EXIT_FAILURE;
+  }
+
+  best = (Playlist *)malloc(sizeof(Playlist) * k);
+  if (!best) {
+    fprintf(stderr, "Error: could not allocate playlists\n");
+    return EXIT_FAILURE;
+  }
+
+  found = playlist_search(r, atol(argv[0]), atoi(argv[1]), k, best, &exact);
+  if (found < 0) {
+    fprintf(stderr, "Error: could not search playlists from %s\n", argv[0]);
+    free(best);
+    return EXIT_FAILURE;
+  }
+
+  printf("Playlists: %d (%s)\n", found, exact == TRUE ? "optimal" : "search stopped early");
+  for (i = 0; i < found; i++) {
+    printf("%d seconds:", best[i].total);
+    for (j = 0; j < best[i].n; j++) printf(" %ld", best[i].ids[j]);
+    printf("\n");
+  }
+
+  playlist_free(best, found);
+  free(best);
+  return EXIT_SUCCESS;
+}
+
+static int cmdSimilar(Radio *r, int argc, char **argv) {
+  RadioSimilarity sim = RADIO_JACCARD;
+  double *scores;
+  long *ids;
+  int i, k, n_similar;
+
+  if (argc < 1) {
+    fprintf(stderr, "Error: similar needs a music id\n");
+    return EXIT_FAILURE;
+  }
+
+  k = (argc > 1) ? atoi(argv[1]) : 10;
+  if (k <= 0) {
+    fprintf(stderr, "Error: invalid number of music\n");
+    return EXIT_FAILURE;
+  }
+  if (argc > 2 && strcmp(argv[2], "adamic-adar") == 0) sim = RADIO_ADAMIC_ADAR;
+
+  scores = (double *)malloc(sizeof(double) * k);
+  if (!scores) {
+    fprintf(stderr, "Error: could not allocate scores\n");
+    return EXIT_FAILURE;
+  }
+
+  ids = radio_similarSongs(r, atol(argv[0]), k, sim, scores, &n_similar);
+  if (!ids && !radio_contains(r, atol(argv[0]))) {
+    fprintf(stderr, "Error: music %s is not in the radio\n", argv[0]);
+    free(scores);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < n_similar; i++) {
+    printf("%.6f ", scores[i]);
+    music_plain_print(stdout, radio_getMusicAt(r, _radio_findmusicById(r, ids[i])));
+    printf("\n");
+  }
+
+  free(ids);
+  free(scores);
+  return EXIT_SUCCESS;
+}
+
+static int cmdClusters(Radio *r, int argc, char **argv) {
+  long *triangles, *cycles;
+  double *coefficients, average = 0;
+  long total, total_cycles = 0;
+  int i, n, n_threads = (argc > 0) ? atoi(argv[0]) : 1;
+
+  if (n_threads <= 0) {
+    fprintf(stderr, "Error: invalid number of threads\n");
+    return EXIT_FAILURE;
+  }
+
+  n = radio_getNumberOfMusic(r);
+  triangles = (long *)malloc(sizeof(long) * (n > 0 ? n : 1));
+  cycles = (long *)malloc(sizeof(long) * (n > 0 ? n : 1));
+  coefficients = (double *)malloc(sizeof(double) * (n > 0 ? n : 1));
+  if (!triangles || !cycles || !coefficients) {
+    fprintf(stderr, "Error: could not allocate counters\n");
+    free(triangles);
+    free(cycles);
+    free(coefficients);
+    return EXIT_FAILURE;
+  }
+
+  total = cluster_triangles(r, n_threads, triangles, cycles, coefficients);
+  if (total < 0) {
+    fprintf(stderr, "Error: could not count triangles\n");
+    free(triangles);
+    free(cycles);
+    free(coefficients);
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < n; i++) {
+    printf("%ld %ld %.6f ", triangles[i], cycles[i], coefficients[i]);
+    music_plain_print(stdout, radio_getMusicAt(r, i));
+    printf("\n");
+    total_cycles += cycles[i];
+    average += coefficients[i];
+  }
+
+  /* Every cycle was credited to its three music */
+  printf("Triangles: %ld\n", total);
+  printf("Directed cycles: %ld\n", total_cycles / 3);
+  printf("Average clustering coefficient: %.6f\n", (n > 0) ? average / n : 0.0);
+
+  free(triangles);
+  free(cycles);
+  free(coefficients);
+  return EXIT_SUCCESS;
+}
+
+static int cmdStats(Radio *r) {
+  RadioStats stats;
+
+  if (radio_getStats(r, &stats) == ERROR) {
+    fprintf(stderr, "Error: could not compute the statistics\n");
+    return EXIT_FAILURE;
+  }
+
+  if (radio_printStats(stdout, &stats) < 0) {
+    fprintf(stderr, "Error: could not print the statistics\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+static int cmdOrder(Radio *r) {
+  int *order;
+  int i, n_order;
+
+  order = radio_topologicalOrder(r, &n_order);
+  if (!order) {
+    if (radio_hasCycle(r) == FALSE) {
+      fprintf(stderr, "Error: could not sort the radio\n");
+      return EXIT_FAILURE;
+    }
+    printf("Cycle: %d of %d music cannot be ordered\n", radio_getNumberOfMusic(r) - n_order,
+           radio_getNumberOfMusic(r));
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < n_order; i++) {
+    music_plain_print(stdout, radio_getMusicAt(r, order[i]));
+    printf("\n");
+  }
+
+  free(order);
+  return EXIT_SUCCESS;
+}
+
+static int cmdShard(Radio *r, int argc, char **argv) {
+  ShardMethod method = SHARD_LOCALITY;
+  FILE *pf;
+  char filename[1024];
+  int *shards, *music, *relations, *ghosts;
+  long cut;
+  int s, n, n_shards, ret = EXIT_SUCCESS;
+
+  if (argc < 1 || (n_shards = atoi(argv[0])) <= 0) {
+    fprintf(stderr, "Error: shard needs a valid number of shards\n");
+    return EXIT_FAILURE;
+  }
+  if (argc > 1 && strcmp(argv[1], "hash") == 0) method = SHARD_HASH;
+
+  n = radio_getNumberOfMusic(r);
+  shards = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  music = (int *)malloc(sizeof(int) * n_shards);
+  relations = (int *)malloc(sizeof(int) * n_shards);
+  ghosts = (int *)malloc(sizeof(int) * n_shards);
+  if (!shards || !music || !relations || !ghosts) {
+    fprintf(stderr, "Error: could not allocate shards\n");
+    ret = EXIT_FAILURE;
+  }
+
+  if (ret == EXIT_SUCCESS && shard_partition(r, n_shards, method, shards) == ERROR) {
+    fprintf(stderr, "Error: could not partition the radio\n");
+    ret = EXIT_FAILURE;
+  }
+
+  cut = (ret == EXIT_SUCCESS) ? shard_cutRelations(r, n_shards, shards, music, relations, ghosts)
+                              : -1;
+  if (ret == EXIT_SUCCESS && cut < 0) {
+    fprintf(stderr, "Error: could not count the cut relations\n");
+    ret = EXIT_FAILURE;
+  }
+
+  for (s = 0; ret == EXIT_SUCCESS && s < n_shards; s++) {
+    printf("Shard %d: %d music, %d relations, %d ghosts\n", s, music[s], relations[s], ghosts[s]);
+
+    if (argc < 3) continue;
+    sprintf(filename, "%.1000s%d.txt", argv[2], s);
+    pf = fopen(filename, "w");
+    if (!pf || shard_write(pf, r, shards, s) < 0) {
+      fprintf(stderr, "Error: could not write shard %s\n", filename);
+      ret = EXIT_FAILURE;
+    }
+    if (pf) fclose(pf);
+  }
+
+  if (ret == EXIT_SUCCESS) {
+    printf("Cut relations: %ld of %d (%.2f%%)\n", cut, radio_getNumberOfRelations(r),
+           radio_getNumberOfRelations(r) > 0 ? 100.0 * cut / radio_getNumberOfRelations(r) : 0.0);
+  }
+
+  free(shards);
+  free(music);
+  free(relations);
+  free(ghosts);
+  return ret;
+}
+
+#define SNAPSHOT_COMMIT_EVERY 16
+
+typedef struct {
+  SnapshotStore *store;
+  int reader;
+  int queries;
+  unsigned int seed;
+  double *latencies;   /* Microseconds of every query */
+} SnapshotReader;
+
+static double elapsedMicros(const struct timespec *start) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1e6 + (now.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void *snapshotReader(void *arg) {
+  SnapshotReader *sr = (SnapshotReader *)arg;
+  const Snapshot *v;
+  struct timespec start;
+  int q, n;
+
+  for (q = 0; q < sr->queries; q++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    v = snapshot_acquire(sr->store, sr->reader);
+    n = snapshot_getNumberOfMusic(v);
+    if (n > 0) {
+      snapshot_distance(v, music_getId(snapshot_getMusicAt(v, rand_r(&sr->seed) % n)),
+                        music_getId(snapshot_getMusicAt(v, rand_r(&sr->seed) % n)));
+    }
+    snapshot_release(sr->store, sr->reader);
+    sr->latencies[q] = elapsedMicros(&start);
+  }
+
+  return NULL;
+}
+
+/* Runs the readers, with a writer in the calling thread if n_relations > 0 */
+static Status snapshotPhase(SnapshotStore *store, SnapshotReader *readers, int n_readers,
+                            int n_relations, const char *label) {
+  pthread_t *threads;
+  const Snapshot *v;
+  double *all;
+  unsigned int seed = 12345;
+  int t, i, n, started = 0, queries = readers[0].queries;
+  Status st = OK;
+
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * n_readers);
+  all = (double *)malloc(sizeof(double) * n_readers * queries);
+  if (!threads || !all) {
+    free(threads);
+    free(all);
+    return ERROR;
+  }
+
+  for (t = 0; t < n_readers; t++) {
+    if (pthread_create(&threads[t], NULL, snapshotReader, &readers[t]) != 0) break;
+    started++;
+  }
+
+  /* The writer reads the version it modifies through its own hazard slot */
+  for (i = 0; st == OK && i < n_relations; i++) {
+    v = snapshot_acquire(store, n_readers);
+    n = snapshot_getNumberOfMusic(v);
+    st = snapshot_newRelation(store, music_getId(snapshot_getMusicAt(v, rand_r(&seed) % n)),
+                              music_getId(snapshot_getMusicAt(v, rand_r(&seed) % n)));
+    snapshot_release(store, n_readers);
+    if (st == OK && (i + 1) % SNAPSHOT_COMMIT_EVERY == 0) st = snapshot_commit(store);
+  }
+  if (st == OK) st = snapshot_commit(store);
+
+  for (t = 0; t < started; t++) pthread_join(threads[t], NULL);
+  if (started < n_readers) st = ERROR;
+
+  if (st == OK) {
+    for (t = 0; t < n_readers; t++) {
+      memcpy(&all[t * queries], readers[t].latencies, sizeof(double) * queries);
+    }
+    qsort(all, (size_t)n_readers * queries, sizeof(double), compareDoubles);
+    n = n_readers * queries;
+    printf("%s: p50 %.1f us, p99 %.1f us, max %.1f us\n", label, all[(n - 1) / 2],
+           all[(int)((n - 1) * 0.99)], all[n - 1]);
+  }
+
+  free(threads);
+  free(all);
+  return st;
+}
+
+static int cmdSnapshot(Radio *r, int argc, char **argv) {
+  SnapshotStore *store;
+  SnapshotReader *readers;
+  const Snapshot *v;
+  int t, n_readers, n_relations, queries, ret = EXIT_SUCCESS;
+
+  if (argc < 2 || (n_readers = atoi(argv[0])) <= 0 || (n_relations = atoi(argv[1])) < 0) {
+    fprintf(stderr, "Error: snapshot needs a number of readers and relations\n");
+    return EXIT_FAILURE;
+  }
+  queries = (argc > 2) ? atoi(argv[2]) : 200;
+  if (queries <= 0 || radio_getNumberOfMusic(r) <= 0) {
+    fprintf(stderr, "Error: invalid number of queries or empty radio\n");
+    return EXIT_FAILURE;
+  }
+
+  store = snapshot_storeNew(r, n_readers + 1);
+  readers = (SnapshotReader *)calloc(n_readers, sizeof(SnapshotReader));
+  if (!store || !readers) {
+    fprintf(stderr, "Error: could not create the snapshot store\n");
+    snapshot_storeFree(store);
+    free(readers);
+    return EXIT_FAILURE;
+  }
+
+  for (t = 0; t < n_readers && ret == EXIT_SUCCESS; t++) {
+    readers[t].store = store;
+    readers[t].reader = t;
+    readers[t].queries = queries;
+    readers[t].seed = (unsigned int)t + 1;
+    readers[t].latencies = (double *)malloc(sizeof(double) * queries);
+    if (!readers[t].latencies) ret = EXIT_FAILURE;
+  }
+
+  if (ret == EXIT_SUCCESS && (snapshotPhase(store, readers, n_readers, 0, "Readers alone") == ERROR ||
+                              snapshotPhase(store, readers, n_readers, n_relations,
+                                            "Readers with writer") == ERROR)) {
+    ret = EXIT_FAILURE;
+  }
+
+  if (ret == EXIT_SUCCESS) {
+    v = snapshot_acquire(store, 0);
+    printf("Version %ld: %d music, %d relations, %d old versions pending\n", snapshot_getNumber(v),
+           snapshot_getNumberOfMusic(v), snapshot_getNumberOfRelations(v),
+           snapshot_reclaim(store));
+    snapshot_release(store, 0);
+  } else {
+    fprintf(stderr, "Error: snapshot benchmark failed\n");
+  }
+
+  for (t = 0; t < n_readers; t++) free(readers[t].latencies);
+  free(readers);
+  snapshot_storeFree(store);
+  return ret;
+}
+
+typedef struct {
+  const Radio *radio;
+  int queries;
+  unsigned int seed;
+} QueryWorker;
+
+static void *queryWorker(void *arg) {
+  QueryWorker *qw = (QueryWorker *)arg;
+  long *path, from, to;
+  int q, n, n_path;
+
+  n = radio_getNumberOfMusic(qw->radio);
+  for (q = 0; q < qw->queries; q++) {
+    from = music_getId(radio_getMusicAt(qw->radio, rand_r(&qw->seed) % n));
+    to = music_getId(radio_getMusicAt(qw->radio, rand_r(&qw->seed) % n));
+    path = radio_shortestPath(qw->radio, from, to, RADIO_RELATION_WEIGHT, &n_path, NULL);
+    free(path);
+  }
+
+  return NULL;
+}
+
+static int cmdConcurrent(Radio *r, int argc, char **argv) {
+  QueryWorker *workers;
+  pthread_t *threads;
+  struct timespec start;
+  double micros, base = 0;
+  int t, n_threads, next, max_threads, queries, started;
+
+  if (argc < 1 || (max_threads = atoi(argv[0])) <= 0) {
+    fprintf(stderr, "Error: concurrent needs a maximum number of threads\n");
+    return EXIT_FAILURE;
+  }
+  queries = (argc > 1) ? atoi(argv[1]) : 2000;
+  if (queries <= 0 || radio_getNumberOfMusic(r) <= 0) {
+    fprintf(stderr, "Error: invalid number of queries or empty radio\n");
+    return EXIT_FAILURE;
+  }
+
+  workers = (QueryWorker *)calloc(max_threads, sizeof(QueryWorker));
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * max_threads);
+  if (!workers || !threads || radio_setConcurrent(r, TRUE) == ERROR) {
+    fprintf(stderr, "Error: could not create the workers\n");
+    free(workers);
+    free(threads);
+    return EXIT_FAILURE;
+  }
+
+  /* The same total number of queries, split among 1, 2, 4, ..., max_threads threads */
+  for (n_threads = 1; n_threads <= max_threads; n_threads = next) {
+    next = (n_threads < max_threads && n_threads * 2 > max_threads) ? max_threads : n_threads * 2;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (t = 0, started = 0; t < n_threads; t++) {
+      workers[t].radio = r;
+      workers[t].queries = queries / n_threads + (t < queries % n_threads);
+      workers[t].seed = (unsigned int)t + 1;
+      if (pthread_create(&threads[t], NULL, queryWorker, &workers[t]) != 0) break;
+      started++;
+    }
+    for (t = 0; t < started; t++) pthread_join(threads[t], NULL);
+    micros = elapsedMicros(&start);
+
+    if (started < n_threads) {
+      fprintf(stderr, "Error: could not start %d threads\n", n_threads);
+      break;
+    }
+    if (n_threads == 1) base = micros;
+    printf("%d threads: %.0f queries/s, speedup %.2f\n", n_threads, queries / (micros / 1e6),
+           base / micros);
+  }
+
+  radio_setConcurrent(r, FALSE);
+  free(workers);
+  free(threads);
+  return EXIT_SUCCESS;
+}
+
+/* Same searches as compact_breadthSearch and compact_depthSearch, over the plain CSR */
+static int csrBreadthSearch(const int *offsets, const int *targets, int n, int from,
+                            int *order) {
+  char *visited;
+  int head = 0, tail = 0, v, k;
+
+  visited = (char *)calloc(n, sizeof(char));
+  if (!visited) return -1;
+
+  visited[from] = 1;
+  order[tail++] = from;
+  while (head < tail) {
+    v = order[head++];
+    for (k = offsets[v]; k < offsets[v + 1]; k++) {
+      if (!visited[targets[k]]) {
+        visited[targets[k]] = 1;
+        order[tail++] = targets[k];
+      }
+    }
+  }
+
+  free(visited);
+  return tail;
+}
+
+static int csrDepthSearch(const int *offsets, const int *targets, int n, int from, int *order) {
+  char *visited;
+  int *stack;
+  int top = 0, count = 0, v, k;
+
+  visited = (char *)calloc(n, sizeof(char));
+  stack = (int *)malloc(sizeof(int) * n);
+  if (!visited || !stack) {
+    free(visited);
+    free(stack);
+    return -1;
+  }
+
+  visited[from] = 1;
+  stack[top++] = from;
+  while (top > 0) {
+    v = stack[--top];
+    order[count++] = v;
+    for (k = offsets[v]; k < offsets[v + 1]; k++) {
+      if (!visited[targets[k]]) {
+        visited[targets[k]] = 1;
+        stack[top++] = targets[k];
+      }
+    }
+  }
+
+  free(visited);
+  free(stack);
+  return count;
+}
+
+/* Runs the same searches over both layouts; returns FALSE if their results differ */
+static Bool compareSearches(const CompactGraph *g, const int *offsets, const int *targets,
+                            int n, int searches, Bool depth_first, int *expected, int *order) {
+  struct timespec start;
+  double csr_micros = 0, compact_micros = 0;
+  long scanned = 0;
+  int s, i, from, n_expected, n_order;
+
+  for (s = 0; s < searches; s++) {
+    /* Origins spread over the whole radio */
+    from = (int)(((long)s * n) / searches);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    n_expected = (depth_first == TRUE) ? csrDepthSearch(offsets, targets, n, from, expected)
+                                       : csrBreadthSearch(offsets, targets, n, from, expected);
+    csr_micros += elapsedMicros(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    n_order = (depth_first == TRUE) ? compact_depthSearch(g, from, order)
+                                    : compact_breadthSearch(g, from, order);
+    compact_micros += elapsedMicros(&start);
+
+    if (n_expected < 0 || n_order != n_expected) return FALSE;
+    for (i = 0; i < n_order; i++) {
+      if (order[i] != expected[i]) return FALSE;
+      scanned += offsets[expected[i] + 1] - offsets[expected[i]];
+    }
+  }
+
+  printf("%s: CSR %.1f M relations/s, compressed %.1f M relations/s (%.2fx)\n",
+         (depth_first == TRUE) ? "DFS" : "BFS", scanned / csr_micros,
+         scanned / compact_micros, csr_micros / compact_micros);
+
+  return TRUE;
+}
+
+static int cmdCompress(Radio *r, int argc, char **argv) {
+  CompactGraph *g;
+  int *offsets = NULL, *targets = NULL, *expected, *order;
+  int n, searches = (argc > 0) ? atoi(argv[0]) : 100;
+  long m;
+  size_t csr_bytes;
+  int ret = EXIT_SUCCESS;
+
+  if (searches <= 0 || radio_getAdjacency(r, &n, &offsets, &targets) == ERROR || n <= 0) {
+    fprintf(stderr, "Error: invalid number of searches or empty radio\n");
+    free(offsets);
+    free(targets);
+    return EXIT_FAILURE;
+  }
+
+  /* The compressed copy must hold the same songs as the CSR one */
+  g = compact_new(r);
+  expected = (int *)malloc(sizeof(int) * n);
+  order = (int *)malloc(sizeof(int) * n);
+  if (!g || !expected || !order || compact_getNumberOfMusic(g) != n) {
+    fprintf(stderr, "Error: could not build the relations\n");
+    compact_free(g);
+    free(offsets);
+    free(targets);
+    free(expected);
+    free(order);
+    return EXIT_FAILURE;
+  }
+
+  m = compact_getNumberOfRelations(g);
+  csr_bytes = sizeof(int) * (n + 1 + m);
+  printf("Relations: %ld\n", m);
+  printf("CSR: %zu bytes, %.2f bits per relation\n", csr_bytes,
+         (m > 0) ? 8.0 * csr_bytes / m : 0.0);
+  printf("Compressed: %zu bytes, %.2f bits per relation (%.1f%% of the CSR)\n",
+         compact_getMemorySize(g), compact_getBitsPerRelation(g),
+         100.0 * compact_getMemorySize(g) / csr_bytes);
+
+  if (compareSearches(g, offsets, targets, n, searches, FALSE, expected, order) == FALSE ||
+      compareSearches(g, offsets, targets, n, searches, TRUE, expected, order) == FALSE) {
+    fprintf(stderr, "Error: the compressed searches do not match the CSR ones\n");
+    ret = EXIT_FAILURE;
+  }
+
+  compact_free(g);
+  free(offsets);
+  free(targets);
+  free(expected);
+  free(order);
+  return ret;
+}
+
+static int cmdLandmarks(Radio *r, int argc, char **argv) {
+  RadioLandmark method = RADIO_LANDMARK_DEGREE;
+  struct timespec start;
+  double exact_micros = 0, estimate_micros = 0;
+  long from, to, total_error = 0;
+  unsigned int seed = 1;
+  int k, n, q, queries, max_error, exact, estimate, found = 0, worst = 0;
+
+  if (argc < 1 || (k = atoi(argv[0])) <= 0 || k > RADIO_MAX_LANDMARKS) {
+    fprintf(stderr, "Error: landmarks needs a number of landmarks up to %d\n",
+            RADIO_MAX_LANDMARKS);
+    return EXIT_FAILURE;
+  }
+  if (argc > 1 && strcmp(argv[1], "random") == 0) method = RADIO_LANDMARK_RANDOM;
+  queries = (argc > 2) ? atoi(argv[2]) : 1000;
+  max_error = (argc > 3) ? atoi(argv[3]) : 1;
+  n = radio_getNumberOfMusic(r);
+  if (queries <= 0 || max_error < 0 || n <= 0) {
+    fprintf(stderr, "Error: invalid queries or error, or empty radio\n");
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (radio_setLandmarks(r, k, method, seed) == ERROR) {
+    fprintf(stderr, "Error: could not compute the landmarks\n");
+    return EXIT_FAILURE;
+  }
+  printf("Landmarks computed in %.0f us\n", elapsedMicros(&start));
+
+  for (q = 0; q < queries; q++) {
+    from = radio_getIdAt(r, rand_r(&seed) % n);
+    to = radio_getIdAt(r, rand_r(&seed) % n);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    exact = radio_estimateDistance(r, from, to, 0);
+    exact_micros += elapsedMicros(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    estimate = radio_estimateDistance(r, from, to, max_error);
+    estimate_micros += elapsedMicros(&start);
+
+    if ((exact < 0) != (estimate < 0) || estimate < exact || estimate > exact + max_error) {
+      fprintf(stderr, "Error: estimate %d for %ld -> %ld, exact %d\n", estimate, from, to,
+              exact);
+      return EXIT_FAILURE;
+    }
+    if (exact < 0) continue;
+    found++;
+    total_error += estimate - exact;
+    if (estimate - exact > worst) worst = estimate - exact;
+  }
+
+  printf("Queries: %d, with path %d\n", queries, found);
+  printf("Exact: %.2f us per query\n", exact_micros / queries);
+  printf("Estimate: %.2f us per query, mean error %.3f, max error %d\n",
+         estimate_micros / queries, (found > 0) ? (double)total_error / found : 0.0, worst);
+
+  return EXIT_SUCCESS;
+}
+
+/* Reads the index from a file if it matches the radio; otherwise builds it and writes it */
+static ReachIndex *loadReachIndex(Radio *r, int n_threads, const char *path) {
+  ReachIndex *ix = NULL;
+  struct timespec start;
+  FILE *pf;
+
+  if (path && (pf = fopen(path, "r"))) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ix = reach_read(pf, r);
+    fclose(pf);
+    if (ix) {
+      printf("Index read from %s in %.0f us\n", path, elapsedMicros(&start));
+      return ix;
+    }
+    fprintf(stderr, "Warning: %s does not match the radio, building the index\n", path);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ix = reach_build(r, n_threads);
+  if (!ix) return NULL;
+  printf("Index built with %d threads in %.0f us\n", n_threads, elapsedMicros(&start));
+
+  if (path) {
+    pf = fopen(path, "w");
+    if (!pf || reach_write(pf, ix, r) == ERROR) {
+      fprintf(stderr, "Warning: could not write the index to %s\n", path);
+    }
+    if (pf) fclose(pf);
+  }
+
+  return ix;
+}
+
+static int cmdReach(Radio *r, int argc, char **argv) {
+  ReachIndex *ix;
+  struct timespec start;
+  double search_micros = 0, index_micros = 0;
+  unsigned int seed = 1;
+  int n, q, queries, n_threads, from, to, found = 0;
+  Bool expected, reachable;
+
+  if (argc < 1 || (n_threads = atoi(argv[0])) <= 0) {
+    fprintf(stderr, "Error: reach needs a positive number of threads\n");
+    return EXIT_FAILURE;
+  }
+  queries = (argc > 2) ? atoi(argv[2]) : 1000;
+  n = radio_getNumberOfMusic(r);
+  if (queries <= 0 || n <= 0) {
+    fprintf(stderr, "Error: invalid number of queries or empty radio\n");
+    return EXIT_FAILURE;
+  }
+
+  ix = loadReachIndex(r, n_threads, (argc > 1) ? argv[1] : NULL);
+  if (!ix) {
+    fprintf(stderr, "Error: could not build the index\n");
+    return EXIT_FAILURE;
+  }
+  printf("Labels: %ld entries, %.2f per music\n", reach_getLabelSize(ix),
+         (double)reach_getLabelSize(ix) / n);
+
+  for (q = 0; q < queries; q++) {
+    from = rand_r(&seed) % n;
+    to = rand_r(&seed) % n;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    expected = (radio_estimateDistance(r, radio_getIdAt(r, from), radio_getIdAt(r, to), 0) >= 0)
+                   ? TRUE
+                   : FALSE;
+    search_micros += elapsedMicros(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    reachable = reach_reachable(ix, from, to);
+    index_micros += elapsedMicros(&start);
+
+    if (reachable != expected) {
+      fprintf(stderr, "Error: index says %s for %ld -> %ld\n",
+              (reachable == TRUE) ? "reachable" : "unreachable", radio_getIdAt(r, from),
+              radio_getIdAt(r, to));
+      reach_free(ix);
+      return EXIT_FAILURE;
+    }
+    if (reachable == TRUE) found++;
+  }
+
+  printf("Queries: %d, reachable %d\n", queries, found);
+  printf("Search: %.2f us per query\n", search_micros / queries);
+  printf("Index: %.3f us per query\n", index_micros / queries);
+
+  reach_free(ix);
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+  FILE *fin = NULL;
+  Radio *radio = NULL;
+  int ret;
+
+  if (argc < 3) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fin = fopen(argv[1], "r");
+  if (!fin) {
+    fprintf(stderr, "Error: could not open file %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  radio = radio_init();
+  if (!radio) {
+    fprintf(stderr, "Error: could not initialize radio\n");
+    fclose(fin);
+    return EXIT_FAILURE;
+  }
+
+  /* A path only needs the music it goes through */
+  if (strcmp(argv[2], "path") == 0) radio_setLazy(radio, TRUE);
+
+  if (radio_readFromFile(fin, radio) == ERROR) {
+    fprintf(stderr, "Error: could not read radio from file %s\n", argv[1]);
+    fclose(fin);
+    radio_free(radio);
+    return EXIT_FAILURE;
+  }
+
+  fclose(fin);
+
+  if (strcmp(argv[2], "rank") == 0) {
+    ret = cmdRank(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "walk") == 0) {
+    ret = cmdWalk(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "path") == 0) {
+    ret = cmdPath(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "fill") == 0) {
+    ret = cmdFill(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "similar") == 0) {
+    ret = cmdSimilar(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "clusters") == 0) {
+    ret = cmdClusters(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "stats") == 0) {
+    ret = cmdStats(radio);
+  } else if (strcmp(argv[2], "shard") == 0) {
+    ret = cmdShard(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "snapshot") == 0) {
+    ret = cmdSnapshot(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "concurrent") == 0) {
+    ret = cmdConcurrent(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "compress") == 0) {
+    ret = cmdCompress(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "order") == 0) {
+    ret = cmdOrder(radio);
+  } else if (strcmp(argv[2], "landmarks") == 0) {
+    ret = cmdLandmarks(radio, argc - 3, argv + 3);
+  } else if (strcmp(argv[2], "reach") == 0) {
+    ret = cmdReach(radio, argc - 3, argv + 3);
+  } else {
+    usage(argv[0]);
+    ret = EXIT_FAILURE;
+  }
+
+  radio_free(radio);
+  return ret;
+}
@@ -0,0 +1,440 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rank.h"
+
+typedef struct _RankGraph {
+  int n;            /* Number of songs */
+  int *in_offsets;  /* CSR offsets of the incoming relations */
+  int *in_sources;  /* Origins of the incoming relations */
+  int *out_degree;  /* Number of outgoing relations of each song */
+  int *offsets;     /* CSR offsets of the outgoing relations */
+  int *targets;     /* Destinations of the outgoing relations */
+} RankGraph;
+
+typedef struct _RankWorker {
+  const RankGraph *g;
+  const double *rank;     /* Ranks of the previous iteration */
+  const double *contrib;  /* rank / out_degree of every song */
+  double *next;           /* Ranks being computed */
+  double *scores;         /* Output of the closeness workers */
+  double base;            /* Teleport plus dangling share */
+  double damping;
+  double diff;            /* L1 distance of this chunk */
+  int first;              /* First song of the chunk */
+  int last;               /* One past the last song of the chunk */
+  Status status;
+} RankWorker;
+
+typedef struct _RankEntry {
+  double score;
+  int index;
+} RankEntry;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static RankGraph *rank_graphNew(const Radio *r);
+static void rank_graphFree(RankGraph *g);
+static RankWorker *rank_workersNew(const RankGraph *g, int n_threads);
+static Status rank_runWorkers(RankWorker *w, int n_threads, void *(*f)(void *));
+static void *rank_pageRankChunk(void *arg);
+static void *rank_closenessChunk(void *arg);
+static int rank_entryCmp(const void *e1, const void *e2);
+static int rank_printLine(FILE *pf, const Radio *r, const RankEntry *e,
+                          const int *offsets, const int *targets);
+
+static RankGraph *rank_graphNew(const Radio *r) {
+  RankGraph *g;
+  int *fill;
+  int i, k, m;
+
+  g = (RankGraph *)calloc(1, sizeof(RankGraph));
+  if (!g) return NULL;
+
+  if (radio_getAdjacency(r, &g->n, &g->offsets, &g->targets) == ERROR) {
+    free(g);
+    return NULL;
+  }
+  m = g->offsets[g->n];
+
+  g->in_offsets = (int *)calloc(g->n + 1, sizeof(int));
+  g->in_sources = (int *)malloc(sizeof(int) * (m > 0 ? m : 1));
+  g->out_degree = (int *)malloc(sizeof(int) * (g->n > 0 ? g->n : 1));
+  fill = (int *)malloc(sizeof(int) * (g->n > 0 ? g->n : 1));
+  if (!g->in_offsets || !g->in_sources || !g->out_degree || !fill) {
+    free(fill);
+    rank_graphFree(g);
+    return NULL;
+  }
+
+  /* Transpose the relations so that every song pulls from its origins */
+  for (i = 0; i < g->n; i++) {
+    g->out_degree[i] = g->offsets[i + 1] - g->offsets[i];
+    for (k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+      g->in_offsets[g->targets[k] + 1]++;
+    }
+  }
+  for (i = 0; i < g->n; i++) {
+    g->in_offsets[i + 1] += g->in_offsets[i];
+    fill[i] = g->in_offsets[i];
+  }
+  for (i = 0; i < g->n; i++) {
+    for (k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+      g->in_sources[fill[g->targets[k]]++] = i;
+    }
+  }
+
+  free(fill);
+  return g;
+}
+
+static void rank_graphFree(RankGraph *g) {
+  if (!g) return;
+
+  free(g->in_offsets);
+  free(g->in_sources);
+  free(g->out_degree);
+  free(g->offsets);
+  free(g->targets);
+  free(g);
+}
+
+/* Splits the songs in n_threads chunks with a similar number of relations */
+static RankWorker *rank_workersNew(const RankGraph *g, int n_threads) {
+  RankWorker *w;
+  long total, share;
+  int t, i = 0;
+
+  w = (RankWorker *)calloc(n_threads, sizeof(RankWorker));
+  if (!w) return NULL;
+
+  total = (long)g->n + g->in_offsets[g->n];
+  for (t = 0; t < n_threads; t++) {
+    w[t].g = g;
+    w[t].first = i;
+    share = total * (t + 1) / n_threads;
+    while (i < g->n && (long)i + g->in_offsets[i] < share) i++;
+    w[t].last = (t == n_threads - 1) ? g->n : i;
+  }
+
+  return w;
+}
+
+/* Runs f over every chunk, the last one in the calling thread */
+static Status rank_runWorkers(RankWorker *w, int n_threads, void *(*f)(void *)) {
+  pthread_t *threads = NULL;
+  Status st = OK;
+  int t, started = 0;
+
+  if (n_threads > 1) {
+    threads = (pthread_t *)malloc(sizeof(pthread_t) * (n_threads - 1));
+    if (!threads) return ERROR;
+
+    for (t = 0; t < n_threads - 1; t++) {
+      if (pthread_create(&threads[t], NULL, f, &w[t]) != 0) break;
+      started++;
+    }
+    /* Chunks that could not get a thread run here */
+    for (t = started; t < n_threads - 1; t++) f(&w[t]);
+  }
+
+  f(&w[n_threads - 1]);
+
+  for (t = 0; t < started; t++) pthread_join(threads[t], NULL);
+  free(threads);
+
+  for (t = 0; t < n_threads; t++) {
+    if (w[t].status == ERROR) st = ERROR;
+  }
+
+  return st;
+}
+
+static void *rank_pageRankChunk(void *arg) {
+  RankWorker *w = (RankWorker *)arg;
+  const int *in_offsets = w->g->in_offsets;
+  const int *in_sources = w->g->in_sources;
+  const double *contrib = w->contrib;
+  const double *rank = w->rank;
+  double *next = w->next;
+  double sum, delta, diff = 0.0;
+  int v, k;
+
+  for (v = w->first; v < w->last; v++) {
+    sum = 0.0;
+    for (k = in_offsets[v]; k < in_offsets[v + 1]; k++) {
+      sum += contrib[in_sources[k]];
+    }
+    next[v] = w->base + w->damping * sum;
+  }
+
+  /* Kept apart from the gather loop so that it vectorizes */
+  for (v = w->first; v < w->last; v++) {
+    delta = next[v] - rank[v];
+    diff += (delta < 0.0) ? -delta : delta;
+  }
+
+  w->diff = diff;
+  w->status = OK;
+
+  return NULL;
+}
+
+static void *rank_closenessChunk(void *arg) {
+  RankWorker *w = (RankWorker *)arg;
+  const RankGraph *g = w->g;
+  int *dist, *queue;
+  int s, v, k, head, tail;
+  double sum;
+
+  w->status = ERROR;
+
+  dist = (int *)malloc(sizeof(int) * g->n);
+  queue = (int *)malloc(sizeof(int) * g->n);
+  if (!dist || !queue) {
+    free(dist);
+    free(queue);
+    return NULL;
+  }
+
+  for (s = w->first; s < w->last; s++) {
+    for (v = 0; v < g->n; v++) dist[v] = -1;
+
+    dist[s] = 0;
+    queue[0] = s;
+    head = 0;
+    tail = 1;
+    sum = 0.0;
+    while (head < tail) {
+      v = queue[head++];
+      if (v != s) sum += 1.0 / dist[v];
+      for (k = g->offsets[v]; k < g->offsets[v + 1]; k++) {
+        if (dist[g->targets[k]] < 0) {
+          dist[g->targets[k]] = dist[v] + 1;
+          queue[tail++] = g->targets[k];
+        }
+      }
+    }
+
+    w->scores[s] = (g->n > 1) ? sum / (g->n - 1) : 0.0;
+  }
+
+  free(dist);
+  free(queue);
+  w->status = OK;
+
+  return NULL;
+}
+
+static int rank_entryCmp(const void *e1, const void *e2) {
+  const RankEntry *a = (const RankEntry *)e1;
+  const RankEntry *b = (const RankEntry *)e2;
+
+  if (a->score > b->score) return -1;
+  if (a->score < b->score) return 1;
+
+  return a->index - b->index;
+}
+
+static int rank_printLine(FILE *pf, const Radio *r, const RankEntry *e,
+                          const int *offsets, const int *targets) {
+  int k, chars = 0, written;
+
+  written = fprintf(pf, "%.6f ", e->score);
+  if (written < 0) return -1;
+  chars += written;
+
+  written = music_plain_print(pf, radio_getMusicAt(r, e->index));
+  if (written < 0) return -1;
+  chars += written;
+
+  written = fprintf(pf, ":");
+  if (written < 0) return -1;
+  chars += written;
+
+  for (k = offsets[e->index]; k < offsets[e->index + 1]; k++) {
+    written = fprintf(pf, " ");
+    if (written < 0) return -1;
+    chars += written;
+
+    written = music_plain_print(pf, radio_getMusicAt(r, targets[k]));
+    if (written < 0) return -1;
+    chars += written;
+  }
+
+  written = fprintf(pf, "\n");
+  if (written < 0) return -1;
+  chars += written;
+
+  return chars;
+}
+
+/*----------------------------------------------------------------------------------------*/
+int rank_pageRank(const Radio *r, double damping, double tolerance,
+                  int max_iter, int n_threads, double *scores) {
+  RankGraph *g;
+  RankWorker *w;
+  double *rank, *next, *contrib, *inv_degree, *dangling_mask, *aux;
+  double dangling, diff;
+  int i, t, iter = 0;
+
+  if (!r || !scores || damping < 0.0 || damping > 1.0 || tolerance <= 0.0 ||
+      max_iter <= 0 || n_threads <= 0) {
+    return -1;
+  }
+
+  g = rank_graphNew(r);
+  if (!g) return -1;
+  if (g->n == 0) {
+    rank_graphFree(g);
+    return 0;
+  }
+  if (n_threads > g->n) n_threads = g->n;
+
+  w = rank_workersNew(g, n_threads);
+  rank = (double *)malloc(sizeof(double) * g->n);
+  next = (double *)malloc(sizeof(double) * g->n);
+  contrib = (double *)malloc(sizeof(double) * g->n);
+  inv_degree = (double *)malloc(sizeof(double) * g->n);
+  dangling_mask = (double *)malloc(sizeof(double) * g->n);
+  if (!w || !rank || !next || !contrib || !inv_degree || !dangling_mask) iter = -1;
+
+  for (i = 0; iter == 0 && i < g->n; i++) {
+    rank[i] = 1.0 / g->n;
+    inv_degree[i] = g->out_degree[i] ? 1.0 / g->out_degree[i] : 0.0;
+    dangling_mask[i] = g->out_degree[i] ? 0.0 : 1.0;
+  }
+
+  while (iter >= 0 && iter < max_iter) {
+    dangling = 0.0;
+    for (i = 0; i < g->n; i++) {
+      contrib[i] = rank[i] * inv_degree[i];
+      dangling += rank[i] * dangling_mask[i];
+    }
+
+    for (t = 0; t < n_threads; t++) {
+      w[t].rank = rank;
+      w[t].contrib = contrib;
+      w[t].next = next;
+      w[t].damping = damping;
+      w[t].base = (1.0 - damping) / g->n + damping * dangling / g->n;
+    }
+    if (rank_runWorkers(w, n_threads, rank_pageRankChunk) == ERROR) {
+      iter = -1;
+      break;
+    }
+
+    diff = 0.0;
+    for (t = 0; t < n_threads; t++) diff += w[t].diff;
+
+    aux = rank;
+    rank = next;
+    next = aux;
+    iter++;
+
+    if (diff < tolerance) break;
+  }
+
+  for (i = 0; iter >= 0 && i < g->n; i++) scores[i] = rank[i];
+
+  free(w);
+  free(rank);
+  free(next);
+  free(contrib);
+  free(inv_degree);
+  free(dangling_mask);
+  rank_graphFree(g);
+
+  return iter;
+}
+
+Status rank_degree(const Radio *r, double *scores) {
+  RankGraph *g;
+  int i;
+
+  if (!r || !scores) return ERROR;
+
+  g = rank_graphNew(r);
+  if (!g) return ERROR;
+
+  for (i = 0; i < g->n; i++) {
+    scores[i] = (g->n > 1) ? (double)(g->out_degree[i] + g->in_offsets[i + 1] - g->in_offsets[i]) /
+                                 (2.0 * (g->n - 1))
+                           : 0.0;
+  }
+
+  rank_graphFree(g);
+  return OK;
+}
+
+Status rank_closeness(const Radio *r, int n_threads, double *scores) {
+  RankGraph *g;
+  RankWorker *w;
+  Status st;
+  int t;
+
+  if (!r || !scores || n_threads <= 0) return ERROR;
+
+  g = rank_graphNew(r);
+  if (!g) return ERROR;
+  if (g->n == 0) {
+    rank_graphFree(g);
+    return OK;
+  }
+  if (n_threads > g->n) n_threads = g->n;
+
+  w = rank_workersNew(g, n_threads);
+  if (!w) {
+    rank_graphFree(g);
+    return ERROR;
+  }
+  for (t = 0; t < n_threads; t++) w[t].scores = scores;
+
+  st = rank_runWorkers(w, n_threads, rank_closenessChunk);
+
+  free(w);
+  rank_graphFree(g);
+
+  return st;
+}
+
+int rank_print(FILE *pf, const Radio *r, const double *scores) {
+  RankEntry *entries;
+  int *offsets = NULL, *targets = NULL;
+  int n, i, chars = 0, written;
+
+  if (!pf || !r || !scores) return -1;
+
+  if (radio_getAdjacency(r, &n, &offsets, &targets) == ERROR) return -1;
+
+  entries = (RankEntry *)malloc(sizeof(RankEntry) * (n > 0 ? n : 1));
+  if (!entries) {
+    free(offsets);
+    free(targets);
+    return -1;
+  }
+
+  for (i = 0; i < n; i++) {
+    entries[i].score = scores[i];
+    entries[i].index = i;
+  }
+  qsort(entries, n, sizeof(RankEntry), rank_entryCmp);
+
+  for (i = 0; i < n; i++) {
+    written = rank_printLine(pf, r, &entries[i], offsets, targets);
+    if (written < 0) {
+      chars = -1;
+      break;
+    }
+    chars += written;
+  }
+
+  free(entries);
+  free(offsets);
+  free(targets);
+
+  return chars;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file rank.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Popularity scores (PageRank, degree and closeness) over a radio
+ *
+ * @details All the functions work over a compact copy of the radio
+ * relations and fill a caller-provided array of scores indexed by song
+ * position (the same position used by radio_getMusicAt).
+ *
+ * @see radio.h
+ */
+
+#ifndef RANK_H
+#define RANK_H
+
+#include <stdio.h>
+
+#include "radio.h"
+#include "types.h"
+
+/**
+ * @brief Default damping factor for rank_pageRank.
+ */
+#define RANK_DAMPING 0.85
+
+/**
+ * @brief Default L1 convergence tolerance for rank_pageRank.
+ */
+#define RANK_TOLERANCE 1e-9
+
+/**
+ * @brief Default maximum number of iterations for rank_pageRank.
+ */
+#define RANK_MAX_ITER 100
+
+/**
+ * @brief Computes the PageRank of every song of a radio.
+ *
+ * Iterates the power method over the incoming relations of each song
+ * until the L1 distance between two consecutive rank vectors is below
+ * tolerance or max_iter iterations have been done. Songs without
+ * outgoing relations spread their rank uniformly. The resulting scores
+ * add up to 1.
+ *
+ * @param r Pointer to the radio.
+ * @param damping Damping factor, in [0, 1].
+ * @param tolerance L1 convergence tolerance, greater than 0.
+ * @param max_iter Maximum number of iterations, greater than 0.
+ * @param n_threads Number of threads to split the songs among (1 means
+ * no extra threads).
+ * @param scores Output array with radio_getNumberOfMusic(r) positions.
+ *
+ * @return The number of iterations done, or -1 if there is any error.
+ */
+int rank_pageRank(const Radio *r, double damping, double tolerance,
+                  int max_iter, int n_threads, double *scores);
+
+/**
+ * @brief Computes the normalized degree of every song of a radio.
+ *
+ * The score of a song is its number of incoming plus outgoing relations
+ * divided by 2 * (n - 1), n being the number of songs.
+ *
+ * @param r Pointer to the radio.
+ * @param scores Output array with radio_getNumberOfMusic(r) positions.
+ *
+ * @return OK or ERROR.
+ */
+Status rank_degree(const Radio *r, double *scores);
+
+/**
+ * @brief Computes the harmonic closeness of every song of a radio.
+ *
+ * The score of a song is the sum of 1/d over every other song reachable
+ * from it, d being the number of relations in the shortest path, divided
+ * by n - 1. It needs one breadth-first search per song, so its cost is
+ * O(n * (n + m)); the searches are split among n_threads threads.
+ *
+ * @param r Pointer to the radio.
+ * @param n_threads Number of threads to split the songs among.
+ * @param scores Output array with radio_getNumberOfMusic(r) positions.
+ *
+ * @return OK or ERROR.
+ */
+Status rank_closeness(const Radio *r, int n_threads, double *scores);
+
+/**
+ * @brief Prints a radio ordered by decreasing score.
+ *
+ * Uses the same format as radio_print, but the lines are sorted by
+ * decreasing score and every line starts with the score of the song.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to the radio.
+ * @param scores Array of scores indexed by song position.
+ *
+ * @return The number of characters printed, or -1 if there is any error.
+ */
+int rank_print(FILE *pf, const Radio *r, const double *scores);
+
+#endif /* RANK_H */
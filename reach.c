@@ -0,0 +1,547 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reach.h"
+
+#define REACH_INIT_LABEL 4
+#define REACH_FCT_LABEL 2
+#define REACH_FNV_OFFSET 0xcbf29ce484222325ULL
+#define REACH_FNV_PRIME 0x100000001b3ULL
+
+/* Ranks of the music of one label, in increasing order */
+typedef struct _ReachLabel {
+  int *rank;
+  int size;
+  int capacity;
+} ReachLabel;
+
+struct _ReachIndex {
+  int num_music;
+  int num_relations;
+  unsigned long long hash;   /* Of the relations the index was built from */
+  ReachLabel *in;    /* Music that reach each music */
+  ReachLabel *out;   /* Music reached from each music */
+};
+
+/* Workspace and result of the two searches from one origin */
+typedef struct _ReachSearch {
+  unsigned int *mark;   /* mark[v] == epoch if the current search saw v */
+  unsigned int epoch;
+  int *queue;
+  int *forward;         /* Music whose in label gets the origin */
+  int n_forward;
+  int *backward;        /* Music whose out label gets the origin */
+  int n_backward;
+} ReachSearch;
+
+typedef struct _ReachBuilder {
+  ReachIndex *ix;
+  int *offsets;           /* CSR of the outgoing relations */
+  int *targets;
+  int *in_offsets;        /* CSR of the incoming relations */
+  int *sources;
+  int *order;             /* Music by rank */
+  ReachSearch *searches;  /* One per thread */
+  int first;              /* Rank of the first origin of the batch */
+  int batch;              /* Number of origins of a batch */
+  int generation;         /* Number of batches started */
+  int pending;            /* Threads still working on the batch */
+  Bool done;
+  pthread_mutex_t mutex;
+  pthread_cond_t start;   /* Signaled when a batch starts or the build ends */
+  pthread_cond_t finish;  /* Signaled when a thread ends its part of a batch */
+} ReachBuilder;
+
+typedef struct _ReachWorker {
+  ReachBuilder *b;
+  int thread;
+} ReachWorker;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static ReachIndex *reach_new(int num_music, int num_relations);
+static Status reach_labelPush(ReachLabel *l, int rank);
+static unsigned long long reach_hash(int n, const int *offsets, const int *targets);
+static Bool reach_intersects(const ReachLabel *a, const ReachLabel *b);
+static int *reach_orderByDegree(int n, const int *offsets, const int *in_offsets);
+static Status reach_incoming(int n, const int *offsets, const int *targets, int **in_offsets,
+                             int **sources);
+static void reach_nextEpoch(ReachSearch *s, int n);
+static void reach_search(const ReachBuilder *b, ReachSearch *s, int rank);
+static Status reach_merge(ReachBuilder *b, const ReachSearch *s, int rank, Bool prune);
+static void *reach_worker(void *arg);
+static Status reach_buildParallel(ReachBuilder *b, int n_threads);
+
+static ReachIndex *reach_new(int num_music, int num_relations) {
+  ReachIndex *ix;
+
+  ix = (ReachIndex *)malloc(sizeof(ReachIndex));
+  if (!ix) return NULL;
+
+  ix->num_music = num_music;
+  ix->num_relations = num_relations;
+  ix->hash = 0;
+  ix->in = (ReachLabel *)calloc(num_music > 0 ? num_music : 1, sizeof(ReachLabel));
+  ix->out = (ReachLabel *)calloc(num_music > 0 ? num_music : 1, sizeof(ReachLabel));
+  if (!ix->in || !ix->out) {
+    reach_free(ix);
+    return NULL;
+  }
+
+  return ix;
+}
+
+static Status reach_labelPush(ReachLabel *l, int rank) {
+  int *rank_array;
+  int capacity;
+
+  if (l->size == l->capacity) {
+    capacity = (l->capacity > 0) ? l->capacity * REACH_FCT_LABEL : REACH_INIT_LABEL;
+    rank_array = (int *)realloc(l->rank, sizeof(int) * capacity);
+    if (!rank_array) return ERROR;
+    l->rank = rank_array;
+    l->capacity = capacity;
+  }
+  l->rank[l->size++] = rank;
+
+  return OK;
+}
+
+/* FNV-1a of the number of music and the bytes of the CSR */
+static unsigned long long reach_hash(int n, const int *offsets, const int *targets) {
+  unsigned long long h = REACH_FNV_OFFSET;
+  unsigned int x;
+  int i, byte;
+
+  for (i = -1; i < n + 1 + offsets[n]; i++) {
+    if (i < 0) {
+      x = (unsigned int)n;
+    } else if (i <= n) {
+      x = (unsigned int)offsets[i];
+    } else {
+      x = (unsigned int)targets[i - n - 1];
+    }
+    for (byte = 0; byte < 4; byte++) {
+      h = (h ^ ((x >> (8 * byte)) & 0xff)) * REACH_FNV_PRIME;
+    }
+  }
+
+  return h;
+}
+
+/* Merge of two sorted labels, stopping at the first common music */
+static Bool reach_intersects(const ReachLabel *a, const ReachLabel *b) {
+  int i = 0, j = 0;
+
+  while (i < a->size && j < b->size) {
+    if (a->rank[i] == b->rank[j]) return TRUE;
+    if (a->rank[i] < b->rank[j]) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+
+  return FALSE;
+}
+
+/* Counting sort by decreasing degree, ties by position */
+static int *reach_orderByDegree(int n, const int *offsets, const int *in_offsets) {
+  int *order, *count;
+  int v, d, max_degree = 0;
+
+  order = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  count = (int *)calloc(offsets[n] + in_offsets[n] + 2, sizeof(int));
+  if (!order || !count) {
+    free(order);
+    free(count);
+    return NULL;
+  }
+
+  for (v = 0; v < n; v++) {
+    d = (offsets[v + 1] - offsets[v]) + (in_offsets[v + 1] - in_offsets[v]);
+    count[d]++;
+    if (d > max_degree) max_degree = d;
+  }
+  /* count[d] becomes the first rank of the music of degree d */
+  for (d = max_degree, v = 0; d >= 0; d--) {
+    v += count[d];
+    count[d] = v - count[d];
+  }
+  for (v = 0; v < n; v++) {
+    d = (offsets[v + 1] - offsets[v]) + (in_offsets[v + 1] - in_offsets[v]);
+    order[count[d]++] = v;
+  }
+
+  free(count);
+
+  return order;
+}
+
+static Status reach_incoming(int n, const int *offsets, const int *targets, int **in_offsets,
+                             int **sources) {
+  int *fill;
+  int v, k;
+
+  *in_offsets = (int *)calloc(n + 1, sizeof(int));
+  *sources = (int *)malloc(sizeof(int) * (offsets[n] > 0 ? offsets[n] : 1));
+  fill = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (!*in_offsets || !*sources || !fill) {
+    free(*in_offsets);
+    free(*sources);
+    free(fill);
+    return ERROR;
+  }
+
+  for (k = 0; k < offsets[n]; k++) (*in_offsets)[targets[k] + 1]++;
+  for (v = 0; v < n; v++) {
+    (*in_offsets)[v + 1] += (*in_offsets)[v];
+    fill[v] = (*in_offsets)[v];
+  }
+  for (v = 0; v < n; v++) {
+    for (k = offsets[v]; k < offsets[v + 1]; k++) (*sources)[fill[targets[k]]++] = v;
+  }
+
+  free(fill);
+
+  return OK;
+}
+
+static void reach_nextEpoch(ReachSearch *s, int n) {
+  if (++s->epoch == 0) {
+    memset(s->mark, 0, sizeof(unsigned int) * n);
+    s->epoch = 1;
+  }
+}
+
+/*
+ * Searches forwards and backwards from the music of the given rank. A
+ * music whose labels already connect it with the origin is neither added
+ * nor expanded.
+ */
+static void reach_search(const ReachBuilder *b, ReachSearch *s, int rank) {
+  const ReachIndex *ix = b->ix;
+  int origin = b->order[rank], n = ix->num_music;
+  int head, tail, u, k;
+
+  reach_nextEpoch(s, n);
+  s->n_forward = 0;
+  head = tail = 0;
+  s->mark[origin] = s->epoch;
+  s->queue[tail++] = origin;
+  while (head < tail) {
+    u = s->queue[head++];
+    if (reach_intersects(&ix->out[origin], &ix->in[u]) == TRUE) continue;
+    s->forward[s->n_forward++] = u;
+    for (k = b->offsets[u]; k < b->offsets[u + 1]; k++) {
+      if (s->mark[b->targets[k]] == s->epoch) continue;
+      s->mark[b->targets[k]] = s->epoch;
+      s->queue[tail++] = b->targets[k];
+    }
+  }
+
+  reach_nextEpoch(s, n);
+  s->n_backward = 0;
+  head = tail = 0;
+  s->mark[origin] = s->epoch;
+  s->queue[tail++] = origin;
+  while (head < tail) {
+    u = s->queue[head++];
+    if (reach_intersects(&ix->out[u], &ix->in[origin]) == TRUE) continue;
+    s->backward[s->n_backward++] = u;
+    for (k = b->in_offsets[u]; k < b->in_offsets[u + 1]; k++) {
+      if (s->mark[b->sources[k]] == s->epoch) continue;
+      s->mark[b->sources[k]] = s->epoch;
+      s->queue[tail++] = b->sources[k];
+    }
+  }
+}
+
+/*
+ * Origins are merged by increasing rank, so the labels stay sorted. With
+ * prune, the music that the labels of lower ranks connect with the origin
+ * are checked again and skipped: a search that ran next to lower ranks of
+ * its batch did not see their labels, and keeps the music they cover.
+ */
+static Status reach_merge(ReachBuilder *b, const ReachSearch *s, int rank, Bool prune) {
+  ReachIndex *ix = b->ix;
+  int origin = b->order[rank];
+  int i, u;
+
+  for (i = 0; i < s->n_forward; i++) {
+    u = s->forward[i];
+    if (prune == TRUE && reach_intersects(&ix->out[origin], &ix->in[u]) == TRUE) continue;
+    if (reach_labelPush(&ix->in[u], rank) == ERROR) return ERROR;
+  }
+  for (i = 0; i < s->n_backward; i++) {
+    u = s->backward[i];
+    if (prune == TRUE && reach_intersects(&ix->out[u], &ix->in[origin]) == TRUE) continue;
+    if (reach_labelPush(&ix->out[u], rank) == ERROR) return ERROR;
+  }
+
+  return OK;
+}
+
+static void *reach_worker(void *arg) {
+  ReachWorker *w = (ReachWorker *)arg;
+  ReachBuilder *b = w->b;
+  int seen = 0, rank;
+
+  while (1) {
+    pthread_mutex_lock(&b->mutex);
+    while (b->generation == seen && b->done == FALSE) pthread_cond_wait(&b->start, &b->mutex);
+    if (b->done == TRUE) {
+      pthread_mutex_unlock(&b->mutex);
+      break;
+    }
+    seen = b->generation;
+    rank = b->first + w->thread;
+    pthread_mutex_unlock(&b->mutex);
+
+    /* The labels are only modified between batches */
+    if (rank < b->ix->num_music) reach_search(b, &b->searches[w->thread], rank);
+
+    pthread_mutex_lock(&b->mutex);
+    b->pending--;
+    pthread_cond_signal(&b->finish);
+    pthread_mutex_unlock(&b->mutex);
+  }
+
+  return NULL;
+}
+
+/* Each thread searches from one origin per batch; the calling thread merges them */
+static Status reach_buildParallel(ReachBuilder *b, int n_threads) {
+  pthread_t *threads;
+  ReachWorker *workers;
+  int t, started = 0;
+  Status st = OK;
+
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * n_threads);
+  workers = (ReachWorker *)malloc(sizeof(ReachWorker) * n_threads);
+  if (!threads || !workers) {
+    free(threads);
+    free(workers);
+    return ERROR;
+  }
+
+  b->generation = 0;
+  b->done = FALSE;
+  pthread_mutex_init(&b->mutex, NULL);
+  pthread_cond_init(&b->start, NULL);
+  pthread_cond_init(&b->finish, NULL);
+
+  for (t = 0; t < n_threads; t++) {
+    workers[t].b = b;
+    workers[t].thread = t;
+    if (pthread_create(&threads[t], NULL, reach_worker, &workers[t]) != 0) break;
+    started++;
+  }
+  if (started == 0) st = ERROR;
+
+  /* The batches have as many origins as threads could be started */
+  b->batch = started;
+  for (b->first = 0; st == OK && b->first < b->ix->num_music; b->first += b->batch) {
+    pthread_mutex_lock(&b->mutex);
+    b->pending = started;
+    b->generation++;
+    pthread_cond_broadcast(&b->start);
+    while (b->pending > 0) pthread_cond_wait(&b->finish, &b->mutex);
+    pthread_mutex_unlock(&b->mutex);
+
+    for (t = 0; st == OK && t < started && b->first + t < b->ix->num_music; t++) {
+      st = reach_merge(b, &b->searches[t], b->first + t, TRUE);
+    }
+  }
+
+  pthread_mutex_lock(&b->mutex);
+  b->done = TRUE;
+  pthread_cond_broadcast(&b->start);
+  pthread_mutex_unlock(&b->mutex);
+  for (t = 0; t < started; t++) pthread_join(threads[t], NULL);
+
+  pthread_mutex_destroy(&b->mutex);
+  pthread_cond_destroy(&b->start);
+  pthread_cond_destroy(&b->finish);
+  free(threads);
+  free(workers);
+
+  return st;
+}
+
+/*----------------------------------------------------------------------------------------*/
+ReachIndex *reach_build(const Radio *r, int n_threads) {
+  ReachBuilder b;
+  int n, t, rank;
+  Status st = OK;
+
+  if (!r || n_threads <= 0) return NULL;
+
+  memset(&b, 0, sizeof(ReachBuilder));
+  if (radio_getAdjacency(r, &n, &b.offsets, &b.targets) == ERROR) return NULL;
+  b.ix = reach_new(n, b.offsets[n]);
+  if (b.ix) b.ix->hash = reach_hash(n, b.offsets, b.targets);
+  if (!b.ix || reach_incoming(n, b.offsets, b.targets, &b.in_offsets, &b.sources) == ERROR) {
+    st = ERROR;
+  }
+  if (st == OK) b.order = reach_orderByDegree(n, b.offsets, b.in_offsets);
+  if (!b.order) st = ERROR;
+
+  b.searches = (ReachSearch *)calloc(n_threads, sizeof(ReachSearch));
+  if (!b.searches) st = ERROR;
+  for (t = 0; st == OK && t < n_threads; t++) {
+    b.searches[t].mark = (unsigned int *)calloc(n > 0 ? n : 1, sizeof(unsigned int));
+    b.searches[t].queue = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+    b.searches[t].forward = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+    b.searches[t].backward = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+    if (!b.searches[t].mark || !b.searches[t].queue || !b.searches[t].forward ||
+        !b.searches[t].backward) {
+      st = ERROR;
+    }
+  }
+
+  if (st == OK && n_threads == 1) {
+    for (rank = 0; st == OK && rank < n; rank++) {
+      reach_search(&b, &b.searches[0], rank);
+      st = reach_merge(&b, &b.searches[0], rank, FALSE);
+    }
+  } else if (st == OK) {
+    st = reach_buildParallel(&b, n_threads);
+  }
+
+  for (t = 0; b.searches && t < n_threads; t++) {
+    free(b.searches[t].mark);
+    free(b.searches[t].queue);
+    free(b.searches[t].forward);
+    free(b.searches[t].backward);
+  }
+  free(b.searches);
+  free(b.offsets);
+  free(b.targets);
+  free(b.in_offsets);
+  free(b.sources);
+  free(b.order);
+
+  if (st == ERROR) {
+    reach_free(b.ix);
+    return NULL;
+  }
+
+  return b.ix;
+}
+
+void reach_free(ReachIndex *ix) {
+  int i;
+
+  if (!ix) return;
+
+  for (i = 0; i < ix->num_music; i++) {
+    if (ix->in) free(ix->in[i].rank);
+    if (ix->out) free(ix->out[i].rank);
+  }
+  free(ix->in);
+  free(ix->out);
+  free(ix);
+}
+
+Bool reach_reachable(const ReachIndex *ix, int from, int to) {
+  if (!ix || from < 0 || to < 0 || from >= ix->num_music || to >= ix->num_music) return FALSE;
+
+  return reach_intersects(&ix->out[from], &ix->in[to]);
+}
+
+int reach_getNumberOfMusic(const ReachIndex *ix) {
+  if (!ix) return -1;
+
+  return ix->num_music;
+}
+
+long reach_getLabelSize(const ReachIndex *ix) {
+  long size = 0;
+  int i;
+
+  if (!ix) return -1;
+
+  for (i = 0; i < ix->num_music; i++) size += ix->in[i].size + ix->out[i].size;
+
+  return size;
+}
+
+Status reach_write(FILE *pf, const ReachIndex *ix, const Radio *r) {
+  int i, k;
+
+  if (!pf || !ix || !r || radio_getNumberOfMusic(r) != ix->num_music) return ERROR;
+
+  if (fprintf(pf, "%d %d %016llx\n", ix->num_music, ix->num_relations, ix->hash) < 0) {
+    return ERROR;
+  }
+
+  for (i = 0; i < ix->num_music; i++) {
+    if (fprintf(pf, "%ld %d", radio_getIdAt(r, i), ix->in[i].size) < 0) return ERROR;
+    for (k = 0; k < ix->in[i].size; k++) {
+      if (fprintf(pf, " %d", ix->in[i].rank[k]) < 0) return ERROR;
+    }
+    if (fprintf(pf, " %d", ix->out[i].size) < 0) return ERROR;
+    for (k = 0; k < ix->out[i].size; k++) {
+      if (fprintf(pf, " %d", ix->out[i].rank[k]) < 0) return ERROR;
+    }
+    if (fprintf(pf, "\n") < 0) return ERROR;
+  }
+
+  return OK;
+}
+
+ReachIndex *reach_read(FILE *pf, const Radio *r) {
+  ReachIndex *ix;
+  ReachLabel *l;
+  int *offsets = NULL, *targets = NULL;
+  unsigned long long hash;
+  long id;
+  int n, m, n_radio, i, k, size, rank, side;
+  Bool same;
+
+  if (!pf || !r) return NULL;
+
+  if (fscanf(pf, "%d %d %llx", &n, &m, &hash) != 3) return NULL;
+
+  /* Same counts are not enough: the relations may have been rewired */
+  if (radio_getAdjacency(r, &n_radio, &offsets, &targets) == ERROR) return NULL;
+  same = (n == n_radio && m == offsets[n_radio] &&
+          hash == reach_hash(n_radio, offsets, targets)) ? TRUE : FALSE;
+  free(offsets);
+  free(targets);
+  if (same == FALSE) return NULL;
+
+  ix = reach_new(n, m);
+  if (!ix) return NULL;
+  ix->hash = hash;
+
+  for (i = 0; i < n; i++) {
+    if (fscanf(pf, "%ld", &id) != 1 || id != radio_getIdAt(r, i)) {
+      reach_free(ix);
+      return NULL;
+    }
+
+    for (side = 0; side < 2; side++) {
+      l = (side == 0) ? &ix->in[i] : &ix->out[i];
+      if (fscanf(pf, "%d", &size) != 1 || size < 0 || size > n) {
+        reach_free(ix);
+        return NULL;
+      }
+      for (k = 0; k < size; k++) {
+        /* Ranks must be valid and increasing */
+        if (fscanf(pf, "%d", &rank) != 1 || rank < 0 || rank >= n ||
+            (l->size > 0 && rank <= l->rank[l->size - 1]) || reach_labelPush(l, rank) == ERROR) {
+          reach_free(ix);
+          return NULL;
+        }
+      }
+    }
+  }
+
+  return ix;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file reach.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Reachability index of a radio with pruned 2-hop labels
+ *
+ * @details Every music a gets an out label, with music reachable from a,
+ * and an in label, with music that reach a. Music b can be reached from
+ * a if and only if the out label of a and the in label of b share a
+ * music, so a query intersects two short sorted lists.
+ *
+ * The labels are built with one breadth-first search forwards and one
+ * backwards from every music, taken by decreasing degree. A search stops
+ * at the music that the labels built so far already connect with its
+ * origin, which keeps the labels small. Origins are processed in batches,
+ * one per thread; the searches of a batch are only pruned by the labels
+ * of the previous batches, and what the other origins of the batch cover
+ * is removed when the batch is merged in rank order. The labels are the
+ * same for any number of threads.
+ *
+ * The index is written as text. The first line has the number of music,
+ * the number of relations and a hash of the relations; then comes one
+ * line per music in position order:
+ * its id, the size and the music of its in label, and the size and the
+ * music of its out label. Music in the labels are given by their rank
+ * (0 for the music of highest degree).
+ *
+ * All the positions are song positions (see radio_getMusicAt).
+ *
+ * @see radio.h
+ */
+
+#ifndef REACH_H
+#define REACH_H
+
+#include <stdio.h>
+
+#include "radio.h"
+#include "types.h"
+
+typedef struct _ReachIndex ReachIndex;
+
+/**
+ * @brief Builds the reachability index of a radio.
+ *
+ * @param r Pointer to the radio.
+ * @param n_threads Number of threads (1 means no extra threads).
+ *
+ * @return A pointer to the index, or NULL if there is any error.
+ */
+ReachIndex *reach_build(const Radio *r, int n_threads);
+
+/**
+ * @brief Frees a reachability index.
+ *
+ * @param ix Pointer to the index.
+ */
+void reach_free(ReachIndex *ix);
+
+/**
+ * @brief Checks if a music can be reached from another one.
+ *
+ * @param ix Pointer to the index.
+ * @param from Position of the origin music.
+ * @param to Position of the destination music.
+ *
+ * @return TRUE if there is a path (every music reaches itself), FALSE if
+ * there is none or there is any error.
+ */
+Bool reach_reachable(const ReachIndex *ix, int from, int to);
+
+/**
+ * @brief Gets the number of music of an index.
+ *
+ * @param ix Pointer to the index.
+ *
+ * @return The number of music, or -1 if there is any error.
+ */
+int reach_getNumberOfMusic(const ReachIndex *ix);
+
+/**
+ * @brief Gets the total size of the labels of an index.
+ *
+ * @param ix Pointer to the index.
+ *
+ * @return The number of music in all the in and out labels, or -1 if
+ * there is any error.
+ */
+long reach_getLabelSize(const ReachIndex *ix);
+
+/**
+ * @brief Writes an index.
+ *
+ * @param pf File descriptor.
+ * @param ix Pointer to the index.
+ * @param r Pointer to the radio of the index.
+ *
+ * @return OK or ERROR.
+ */
+Status reach_write(FILE *pf, const ReachIndex *ix, const Radio *r);
+
+/**
+ * @brief Reads an index written by reach_write.
+ *
+ * The index is rejected if its number of music, number of relations, hash
+ * of the relations or ids do not match the radio.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to the radio of the index.
+ *
+ * @return A pointer to the index, or NULL if there is any error.
+ */
+ReachIndex *reach_read(FILE *pf, const Radio *r);
+
+#endif /* REACH_H */
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "shard.h"
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static unsigned long shard_hash(long id);
+static Status shard_neighbours(const Radio *r, int *n_music, int **offsets, int **neighbours);
+static Status shard_grow(int n, int n_shards, const int *offsets, const int *neighbours,
+                         int *shards, int *size);
+static Status shard_refine(int n, int n_shards, const int *offsets, const int *neighbours,
+                           int *shards, int *size);
+static int shard_writeMusic(FILE *pf, const Radio *r, int i);
+
+/* Finalizer of splitmix64, so that consecutive ids spread over all the shards */
+static unsigned long shard_hash(long id) {
+  unsigned long x = (unsigned long)id;
+
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9UL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebUL;
+
+  return x ^ (x >> 31);
+}
+
+/*
+ * Neighbours of every music ignoring directions; reciprocal relations appear twice.
+ * n_music gets the number of music of the same read as the lists.
+ */
+static Status shard_neighbours(const Radio *r, int *n_music, int **offsets, int **neighbours) {
+  int *out_offsets = NULL, *out_targets = NULL, *fill;
+  int n, m, i, k;
+
+  if (radio_getAdjacency(r, &n, &out_offsets, &out_targets) == ERROR) return ERROR;
+  m = out_offsets[n];
+
+  *offsets = (int *)calloc(n + 1, sizeof(int));
+  *neighbours = (int *)malloc(sizeof(int) * (2 * m > 0 ? 2 * m : 1));
+  fill = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (!*offsets || !*neighbours || !fill) {
+    free(*offsets);
+    free(*neighbours);
+    free(fill);
+    free(out_offsets);
+    free(out_targets);
+    return ERROR;
+  }
+
+  for (i = 0; i < n; i++) {
+    (*offsets)[i + 1] += out_offsets[i + 1] - out_offsets[i];
+    for (k = out_offsets[i]; k < out_offsets[i + 1]; k++) (*offsets)[out_targets[k] + 1]++;
+  }
+  for (i = 0; i < n; i++) {
+    (*offsets)[i + 1] += (*offsets)[i];
+    fill[i] = (*offsets)[i];
+  }
+  for (i = 0; i < n; i++) {
+    for (k = out_offsets[i]; k < out_offsets[i + 1]; k++) {
+      (*neighbours)[fill[i]++] = out_targets[k];
+      (*neighbours)[fill[out_targets[k]]++] = i;
+    }
+  }
+
+  free(fill);
+  free(out_offsets);
+  free(out_targets);
+  *n_music = n;
+
+  return OK;
+}
+
+static Status shard_grow(int n, int n_shards, const int *offsets, const int *neighbours,
+                         int *shards, int *size) {
+  int *queue;
+  int capacity = (n + n_shards - 1) / n_shards;
+  int s, seed = 0, head, tail, v, k;
+
+  queue = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (!queue) return ERROR;
+
+  for (v = 0; v < n; v++) shards[v] = -1;
+
+  for (s = 0; s < n_shards; s++) {
+    size[s] = 0;
+    head = tail = 0;
+
+    /* The last shard takes whatever is left */
+    while (size[s] < capacity || s == n_shards - 1) {
+      if (head == tail) {
+        while (seed < n && shards[seed] >= 0) seed++;
+        if (seed == n) break;
+        shards[seed] = s;
+        size[s]++;
+        queue[tail++] = seed;
+        continue;
+      }
+
+      v = queue[head++];
+      for (k = offsets[v]; k < offsets[v + 1]; k++) {
+        if (shards[neighbours[k]] >= 0) continue;
+        if (size[s] == capacity && s != n_shards - 1) break;
+        shards[neighbours[k]] = s;
+        size[s]++;
+        queue[tail++] = neighbours[k];
+      }
+    }
+  }
+
+  free(queue);
+
+  return OK;
+}
+
+static Status shard_refine(int n, int n_shards, const int *offsets, const int *neighbours,
+                           int *shards, int *size) {
+  int *count;
+  int capacity = (n + n_shards - 1) / n_shards;
+  int pass, moves, v, k, best;
+
+  count = (int *)calloc(n_shards, sizeof(int));
+  if (!count) return ERROR;
+
+  for (pass = 0, moves = 1; pass < SHARD_REFINE_PASSES && moves > 0; pass++) {
+    moves = 0;
+    for (v = 0; v < n; v++) {
+      for (k = offsets[v]; k < offsets[v + 1]; k++) count[shards[neighbours[k]]]++;
+
+      best = shards[v];
+      for (k = offsets[v]; k < offsets[v + 1]; k++) {
+        if (size[shards[neighbours[k]]] < capacity &&
+            count[shards[neighbours[k]]] > count[best]) {
+          best = shards[neighbours[k]];
+        }
+      }
+
+      if (best != shards[v] && size[shards[v]] > 1) {
+        size[shards[v]]--;
+        size[best]++;
+        shards[v] = best;
+        moves++;
+      }
+
+      for (k = offsets[v]; k < offsets[v + 1]; k++) count[shards[neighbours[k]]] = 0;
+    }
+  }
+
+  free(count);
+
+  return OK;
+}
+
+/* The strings come from the handle: those of the radio pool may move if music are added */
+static int shard_writeMusic(FILE *pf, const Radio *r, int i) {
+  const Music *m = radio_getMusicAt(r, i);
+
+  if (!m) return -1;
+
+  return fprintf(pf, "id:\"%ld\" title:\"%s\" artist:\"%s\" duration:\"%hu\" state:\"%d\"\n",
+                 music_getId(m), music_getTitle(m), music_getArtist(m), music_getDuration(m),
+                 (int)music_getState(m));
+}
+
+/*----------------------------------------------------------------------------------------*/
+Status shard_partition(const Radio *r, int n_shards, ShardMethod method, int *shards) {
+  int *offsets = NULL, *neighbours = NULL, *size;
+  int n, v;
+  Status st;
+
+  if (!r || !shards || n_shards <= 0) return ERROR;
+
+  /* Music added meanwhile are left out by both methods, as they are not in the lists */
+  if (shard_neighbours(r, &n, &offsets, &neighbours) == ERROR) return ERROR;
+
+  if (method == SHARD_HASH) {
+    for (v = 0; v < n; v++) {
+      shards[v] = (int)(shard_hash(radio_getIdAt(r, v)) % (unsigned long)n_shards);
+    }
+    free(offsets);
+    free(neighbours);
+    return OK;
+  }
+
+  size = (int *)malloc(sizeof(int) * n_shards);
+  st = (size) ? shard_grow(n, n_shards, offsets, neighbours, shards, size) : ERROR;
+  if (st == OK) st = shard_refine(n, n_shards, offsets, neighbours, shards, size);
+
+  free(size);
+  free(offsets);
+  free(neighbours);
+
+  return st;
+}
+
+long shard_cutRelations(const Radio *r, int n_shards, const int *shards, int *music,
+                        int *relations, int *ghosts) {
+  int *offsets = NULL, *targets = NULL, *last_seen;
+  long cut = 0;
+  int n, s, v, k;
+
+  if (!r || !shards || n_shards <= 0) return -1;
+
+  if (radio_getAdjacency(r, &n, &offsets, &targets) == ERROR) return -1;
+
+  /* last_seen[w] is the last shard that counted w as a ghost */
+  last_seen = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (!last_seen) {
+    free(offsets);
+    free(targets);
+    return -1;
+  }
+
+  for (s = 0; s < n_shards; s++) {
+    if (music) music[s] = 0;
+    if (relations) relations[s] = 0;
+    if (ghosts) ghosts[s] = 0;
+  }
+  for (v = 0; v < n; v++) last_seen[v] = -1;
+
+  /* Music are visited shard by shard so that last_seen detects repeated ghosts */
+  for (s = 0; s < n_shards; s++) {
+    for (v = 0; v < n; v++) {
+      if (shards[v] != s) continue;
+
+      if (music) music[s]++;
+      if (relations) relations[s] += offsets[v + 1] - offsets[v];
+      for (k = offsets[v]; k < offsets[v + 1]; k++) {
+        if (shards[targets[k]] == s) continue;
+        cut++;
+        if (last_seen[targets[k]] != s) {
+          last_seen[targets[k]] = s;
+          if (ghosts) ghosts[s]++;
+        }
+      }
+    }
+  }
+
+  free(last_seen);
+  free(offsets);
+  free(targets);
+
+  return cut;
+}
+
+int shard_write(FILE *pf, const Radio *r, const int *shards, int shard) {
+  int *offsets = NULL, *targets = NULL, *ghost;
+  double *weights = NULL;
+  int n, v, k, n_own = 0, n_ghosts = 0;
+  Status st = OK;
+
+  if (!pf || !r || !shards || shard < 0) return -1;
+
+  if (radio_getWeightedAdjacency(r, &n, &offsets, &targets, &weights) == ERROR) return -1;
+
+  ghost = (int *)calloc(n > 0 ? n : 1, sizeof(int));
+  if (!ghost) {
+    free(offsets);
+    free(targets);
+    free(weights);
+    return -1;
+  }
+
+  for (v = 0; v < n; v++) {
+    if (shards[v] != shard) continue;
+    n_own++;
+    for (k = offsets[v]; k < offsets[v + 1]; k++) {
+      if (shards[targets[k]] != shard && !ghost[targets[k]]) {
+        ghost[targets[k]] = 1;
+        n_ghosts++;
+      }
+    }
+  }
+
+  if (fprintf(pf, "%d %d\n", n_own + n_ghosts, n_ghosts) < 0) st = ERROR;
+  for (v = 0; st == OK && v < n; v++) {
+    if (shards[v] == shard && shard_writeMusic(pf, r, v) < 0) st = ERROR;
+  }
+  for (v = 0; st == OK && v < n; v++) {
+    if (ghost[v] && shard_writeMusic(pf, r, v) < 0) st = ERROR;
+  }
+
+  for (v = 0; st == OK && v < n; v++) {
+    if (shards[v] != shard || offsets[v] == offsets[v + 1]) continue;
+
+    if (fprintf(pf, "%ld", radio_getIdAt(r, v)) < 0) st = ERROR;
+    for (k = offsets[v]; st == OK && k < offsets[v + 1]; k++) {
+      if (weights[k] == RADIO_DEFAULT_WEIGHT) {
+        if (fprintf(pf, " %ld", radio_getIdAt(r, targets[k])) < 0) st = ERROR;
+      } else {
+        if (fprintf(pf, " %ld:%.17g", radio_getIdAt(r, targets[k]), weights[k]) < 0) {
+          st = ERROR;
+        }
+      }
+    }
+    if (st == OK && fprintf(pf, "\n") < 0) st = ERROR;
+  }
+
+  free(ghost);
+  free(offsets);
+  free(targets);
+  free(weights);
+
+  return (st == OK) ? n_ghosts : -1;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file shard.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Partitioning of a radio into shards
+ *
+ * @details Every music is assigned to one shard, so that separate
+ * processes can each load one part of a radio. A relation is cut when
+ * its origin and destination are in different shards. The ghosts of a
+ * shard are the music of other shards reached by its cut relations; they
+ * are written with the shard so that its relations can be loaded.
+ *
+ * All the arrays are indexed by song position (see radio_getMusicAt).
+ *
+ * @see radio.h
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdio.h>
+
+#include "radio.h"
+#include "types.h"
+
+/**
+ * @brief Maximum number of improvement passes of SHARD_LOCALITY.
+ */
+#define SHARD_REFINE_PASSES 4
+
+/**
+ * @brief Ways of assigning music to shards.
+ */
+typedef enum {
+    SHARD_HASH,     /*!< Hash of the music id, no locality */
+    SHARD_LOCALITY  /*!< Balanced regions grown by BFS, then refined to cut fewer relations */
+} ShardMethod;
+
+/**
+ * @brief Assigns every music of a radio to a shard.
+ *
+ * SHARD_LOCALITY grows each shard by breadth-first search (ignoring the
+ * direction of the relations) up to ceil(n / n_shards) music, and then
+ * moves music to the shard holding most of their neighbours while that
+ * does not exceed the size limit.
+ *
+ * @param r Pointer to the radio.
+ * @param n_shards Number of shards.
+ * @param method Partitioning method.
+ * @param shards Output array with the shard, in [0, n_shards), of each
+ * music.
+ *
+ * @return OK or ERROR.
+ */
+Status shard_partition(const Radio *r, int n_shards, ShardMethod method, int *shards);
+
+/**
+ * @brief Computes the size of every shard and the cut relations.
+ *
+ * @param r Pointer to the radio.
+ * @param n_shards Number of shards.
+ * @param shards Shard of each music.
+ * @param music Output array with the number of music of each shard (can
+ * be NULL).
+ * @param relations Output array with the number of relations leaving the
+ * music of each shard (can be NULL).
+ * @param ghosts Output array with the number of ghosts of each shard (can
+ * be NULL).
+ *
+ * @return The number of cut relations, or -1 if there is any error.
+ */
+long shard_cutRelations(const Radio *r, int n_shards, const int *shards, int *music,
+                        int *relations, int *ghosts);
+
+/**
+ * @brief Writes one shard in the format read by radio_readFromFile.
+ *
+ * The first line holds the number of music followed by the number of
+ * ghosts (radio_readFromFile only reads the first one). The music of the
+ * shard come first and its ghosts last; only the relations leaving the
+ * music of the shard are written.
+ *
+ * @param pf File descriptor.
+ * @param r Pointer to the radio.
+ * @param shards Shard of each music.
+ * @param shard Shard to write.
+ *
+ * @return The number of ghosts written, or -1 if there is any error.
+ */
+int shard_write(FILE *pf, const Radio *r, const int *shards, int shard);
+
+#endif /* SHARD_H */
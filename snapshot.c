@@ -0,0 +1,687 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+#define INIT_LIST 4
+#define FCT_LIST 2
+#define INIT_BLOCKS 4
+#define SNAPSHOT_ID_BUCKETS 1024   /* Power of 2 */
+
+/* Sorted destinations of one music; shared by every block that points to it */
+typedef struct _SnapshotList {
+  int refs;         /* Number of blocks pointing to the list */
+  long stamp;       /* Version that created the list */
+  int size;         /* Number of relations */
+  int capacity;     /* Capacity of dest */
+  int dest[];       /* Positions of the destinations */
+} SnapshotList;
+
+/* SNAPSHOT_BLOCK consecutive music and their relations */
+typedef struct _SnapshotBlock {
+  int refs;                             /* Number of versions pointing to the block */
+  long stamp;                           /* Version that created the block */
+  Music *songs[SNAPSHOT_BLOCK];         /* Music, shared by all the versions */
+  SnapshotList *lists[SNAPSHOT_BLOCK];  /* Relations, NULL if there are none */
+} SnapshotBlock;
+
+typedef struct _SnapshotId {
+  long id;
+  int index;        /* Position of the music */
+} SnapshotId;
+
+/* Music of one bucket of the id index sorted by id; shared like the lists */
+typedef struct _SnapshotIds {
+  int refs;           /* Number of versions pointing to the bucket */
+  long stamp;         /* Version that created the bucket */
+  int size;           /* Number of music */
+  int capacity;       /* Capacity of entry */
+  SnapshotId entry[];
+} SnapshotIds;
+
+struct _Snapshot {
+  long number;              /* Version number */
+  int num_music;            /* Total number of music */
+  int num_relations;        /* Total number of relations */
+  int num_blocks;           /* Blocks in use */
+  int capacity;             /* Capacity of blocks */
+  SnapshotBlock **blocks;   /* Table of blocks */
+  SnapshotIds **ids;        /* Id index, SNAPSHOT_ID_BUCKETS buckets, NULL if empty */
+  Snapshot *next;           /* Next retired version */
+};
+
+/* Workspace of snapshot_distance, one per reader thread */
+typedef struct _SnapshotScratch {
+  unsigned int *mark;   /* mark[i] == epoch if music i was seen */
+  unsigned int epoch;   /* Current search */
+  int *queue;
+  int capacity;         /* Capacity of mark and queue */
+} SnapshotScratch;
+
+struct _SnapshotStore {
+  _Atomic(Snapshot *) current;   /* Version given to new readers */
+  _Atomic(Snapshot *) *hazards;  /* Version held by each reader */
+  int max_readers;               /* Number of hazard slots */
+  Snapshot *draft;               /* Next version, private to the writer */
+  Snapshot *retired;             /* Old versions not freed yet */
+};
+
+static pthread_key_t snapshot_scratch_key;
+static pthread_once_t snapshot_scratch_once = PTHREAD_ONCE_INIT;
+static Bool snapshot_scratch_ready = FALSE;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static void snapshot_listRelease(SnapshotList *l);
+static void snapshot_idsRelease(SnapshotIds *ids);
+static unsigned int snapshot_hashId(long id);
+static int snapshot_idsFind(const SnapshotIds *ids, long id);
+static void snapshot_blockRelease(SnapshotBlock *b);
+static void snapshot_versionFree(Snapshot *v);
+static Snapshot *snapshot_versionNew(long number, int capacity);
+static Snapshot *snapshot_draft(SnapshotStore *s);
+static SnapshotBlock *snapshot_ownBlock(Snapshot *d, int b);
+static SnapshotList *snapshot_ownList(Snapshot *d, SnapshotBlock *blk, int j);
+static Status snapshot_insertId(Snapshot *d, long id, int index);
+static Status snapshot_appendMusic(Snapshot *d, Music *m);
+static Status snapshot_insertRelation(Snapshot *d, int i_orig, int i_dest);
+static Bool snapshot_isHeld(const SnapshotStore *s, const Snapshot *v);
+static void snapshot_scratchCreateKey(void);
+static void snapshot_scratchFree(void *scratch);
+static SnapshotScratch *snapshot_getScratch(int n);
+
+static void snapshot_listRelease(SnapshotList *l) {
+  if (l && --l->refs == 0) free(l);
+}
+
+static void snapshot_idsRelease(SnapshotIds *ids) {
+  if (ids && --ids->refs == 0) free(ids);
+}
+
+/* Fibonacci hashing of the id into [0, SNAPSHOT_ID_BUCKETS) */
+static unsigned int snapshot_hashId(long id) {
+  unsigned long long x = (unsigned long long)id * 0x9E3779B97F4A7C15ULL;
+
+  return (unsigned int)((x >> 32) & (SNAPSHOT_ID_BUCKETS - 1));
+}
+
+/* Position in the bucket of the first entry with an id not lower than id */
+static int snapshot_idsFind(const SnapshotIds *ids, long id) {
+  int low = 0, high, mid;
+
+  if (!ids) return 0;
+
+  high = ids->size;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (ids->entry[mid].id < id) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+static void snapshot_blockRelease(SnapshotBlock *b) {
+  int j;
+
+  if (!b || --b->refs > 0) return;
+
+  for (j = 0; j < SNAPSHOT_BLOCK; j++) snapshot_listRelease(b->lists[j]);
+  free(b);
+}
+
+static void snapshot_versionFree(Snapshot *v) {
+  int b;
+
+  if (!v) return;
+
+  for (b = 0; b < v->num_blocks; b++) snapshot_blockRelease(v->blocks[b]);
+  for (b = 0; v->ids && b < SNAPSHOT_ID_BUCKETS; b++) snapshot_idsRelease(v->ids[b]);
+  free(v->blocks);
+  free(v->ids);
+  free(v);
+}
+
+static Snapshot *snapshot_versionNew(long number, int capacity) {
+  Snapshot *v;
+
+  v = (Snapshot *)calloc(1, sizeof(Snapshot));
+  if (!v) return NULL;
+
+  v->blocks = (SnapshotBlock **)malloc(sizeof(SnapshotBlock *) * capacity);
+  v->ids = (SnapshotIds **)calloc(SNAPSHOT_ID_BUCKETS, sizeof(SnapshotIds *));
+  if (!v->blocks || !v->ids) {
+    free(v->blocks);
+    free(v->ids);
+    free(v);
+    return NULL;
+  }
+  v->number = number;
+  v->capacity = capacity;
+
+  return v;
+}
+
+/* The draft starts as a copy of the block table of the current version */
+static Snapshot *snapshot_draft(SnapshotStore *s) {
+  Snapshot *cur, *d;
+  int b;
+
+  if (s->draft) return s->draft;
+
+  cur = atomic_load(&s->current);
+  d = snapshot_versionNew(cur->number + 1, cur->capacity);
+  if (!d) return NULL;
+
+  d->num_music = cur->num_music;
+  d->num_relations = cur->num_relations;
+  d->num_blocks = cur->num_blocks;
+  for (b = 0; b < cur->num_blocks; b++) {
+    d->blocks[b] = cur->blocks[b];
+    d->blocks[b]->refs++;
+  }
+  for (b = 0; b < SNAPSHOT_ID_BUCKETS; b++) {
+    d->ids[b] = cur->ids[b];
+    if (d->ids[b]) d->ids[b]->refs++;
+  }
+
+  s->draft = d;
+
+  return d;
+}
+
+/* Copies block b of the draft unless the draft created it */
+static SnapshotBlock *snapshot_ownBlock(Snapshot *d, int b) {
+  SnapshotBlock *blk = d->blocks[b], *copy;
+  int j;
+
+  if (blk->stamp == d->number) return blk;
+
+  copy = (SnapshotBlock *)malloc(sizeof(SnapshotBlock));
+  if (!copy) return NULL;
+
+  memcpy(copy, blk, sizeof(SnapshotBlock));
+  copy->refs = 1;
+  copy->stamp = d->number;
+  for (j = 0; j < SNAPSHOT_BLOCK; j++) {
+    if (copy->lists[j]) copy->lists[j]->refs++;
+  }
+
+  blk->refs--;
+  d->blocks[b] = copy;
+
+  return copy;
+}
+
+/* Returns list j of an owned block with room for one more relation */
+static SnapshotList *snapshot_ownList(Snapshot *d, SnapshotBlock *blk, int j) {
+  SnapshotList *l = blk->lists[j], *copy;
+  int capacity;
+
+  if (l && l->stamp == d->number && l->size < l->capacity) return l;
+
+  capacity = INIT_LIST;
+  if (l && l->size >= capacity) capacity = l->size * FCT_LIST;
+
+  copy = (SnapshotList *)malloc(sizeof(SnapshotList) + sizeof(int) * capacity);
+  if (!copy) return NULL;
+
+  copy->refs = 1;
+  copy->stamp = d->number;
+  copy->capacity = capacity;
+  copy->size = 0;
+  if (l) {
+    memcpy(copy->dest, l->dest, sizeof(int) * l->size);
+    copy->size = l->size;
+  }
+
+  snapshot_listRelease(l);
+  blk->lists[j] = copy;
+
+  return copy;
+}
+
+/* Adds an id to its bucket, copying the bucket unless the draft created it */
+static Status snapshot_insertId(Snapshot *d, long id, int index) {
+  SnapshotIds *ids, *copy;
+  unsigned int h = snapshot_hashId(id);
+  int capacity, k;
+
+  ids = d->ids[h];
+  k = snapshot_idsFind(ids, id);
+  if (!ids || ids->stamp != d->number || ids->size == ids->capacity) {
+    capacity = INIT_LIST;
+    if (ids && ids->size >= capacity) capacity = ids->size * FCT_LIST;
+
+    copy = (SnapshotIds *)malloc(sizeof(SnapshotIds) + sizeof(SnapshotId) * capacity);
+    if (!copy) return ERROR;
+
+    copy->refs = 1;
+    copy->stamp = d->number;
+    copy->capacity = capacity;
+    copy->size = 0;
+    if (ids) {
+      memcpy(copy->entry, ids->entry, sizeof(SnapshotId) * ids->size);
+      copy->size = ids->size;
+    }
+
+    snapshot_idsRelease(ids);
+    d->ids[h] = ids = copy;
+  }
+
+  memmove(&ids->entry[k + 1], &ids->entry[k], sizeof(SnapshotId) * (ids->size - k));
+  ids->entry[k].id = id;
+  ids->entry[k].index = index;
+  ids->size++;
+
+  return OK;
+}
+
+static Status snapshot_appendMusic(Snapshot *d, Music *m) {
+  SnapshotBlock *blk, **blocks;
+  int b;
+
+  if (!m) return ERROR;
+
+  b = d->num_music / SNAPSHOT_BLOCK;
+  if (b == d->num_blocks) {
+    if (d->num_blocks == d->capacity) {
+      blocks = (SnapshotBlock **)realloc(d->blocks, sizeof(SnapshotBlock *) * d->capacity * 2);
+      if (!blocks) return ERROR;
+      d->blocks = blocks;
+      d->capacity *= 2;
+    }
+
+    blk = (SnapshotBlock *)calloc(1, sizeof(SnapshotBlock));
+    if (!blk) return ERROR;
+    blk->refs = 1;
+    blk->stamp = d->number;
+    d->blocks[d->num_blocks++] = blk;
+  } else {
+    blk = snapshot_ownBlock(d, b);
+    if (!blk) return ERROR;
+  }
+  if (snapshot_insertId(d, music_getId(m), d->num_music) == ERROR) return ERROR;
+
+  music_setIndex(m, d->num_music);
+  blk->songs[d->num_music % SNAPSHOT_BLOCK] = m;
+  d->num_music++;
+
+  return OK;
+}
+
+static Status snapshot_insertRelation(Snapshot *d, int i_orig, int i_dest) {
+  SnapshotBlock *blk;
+  SnapshotList *l;
+  const int *list;
+  int n, low = 0, high, mid;
+
+  /* Look for the relation before copying anything */
+  list = snapshot_getRelationsAt(d, i_orig, &n);
+  high = n;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (list[mid] < i_dest) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low < n && list[low] == i_dest) return OK;
+
+  blk = snapshot_ownBlock(d, i_orig / SNAPSHOT_BLOCK);
+  if (!blk) return ERROR;
+  l = snapshot_ownList(d, blk, i_orig % SNAPSHOT_BLOCK);
+  if (!l) return ERROR;
+
+  memmove(&l->dest[low + 1], &l->dest[low], sizeof(int) * (l->size - low));
+  l->dest[low] = i_dest;
+  l->size++;
+  d->num_relations++;
+
+  return OK;
+}
+
+static Bool snapshot_isHeld(const SnapshotStore *s, const Snapshot *v) {
+  int i;
+
+  for (i = 0; i < s->max_readers; i++) {
+    if (atomic_load(&s->hazards[i]) == v) return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void snapshot_scratchCreateKey(void) {
+  if (pthread_key_create(&snapshot_scratch_key, snapshot_scratchFree) == 0) {
+    snapshot_scratch_ready = TRUE;
+  }
+}
+
+static void snapshot_scratchFree(void *scratch) {
+  if (!scratch) return;
+
+  free(((SnapshotScratch *)scratch)->mark);
+  free(((SnapshotScratch *)scratch)->queue);
+  free(scratch);
+}
+
+/* Workspace of the calling thread for n music, with a new epoch */
+static SnapshotScratch *snapshot_getScratch(int n) {
+  SnapshotScratch *sc;
+  unsigned int *mark;
+  int *queue;
+
+  pthread_once(&snapshot_scratch_once, snapshot_scratchCreateKey);
+  if (snapshot_scratch_ready == FALSE) return NULL;
+
+  sc = (SnapshotScratch *)pthread_getspecific(snapshot_scratch_key);
+  if (!sc) {
+    sc = (SnapshotScratch *)calloc(1, sizeof(SnapshotScratch));
+    if (!sc) return NULL;
+    if (pthread_setspecific(snapshot_scratch_key, sc) != 0) {
+      free(sc);
+      return NULL;
+    }
+  }
+
+  /* Versions only grow, so the workspace is reallocated a few times at most */
+  if (sc->capacity < n) {
+    mark = (unsigned int *)calloc(n, sizeof(unsigned int));
+    queue = (int *)malloc(sizeof(int) * n);
+    if (!mark || !queue) {
+      free(mark);
+      free(queue);
+      return NULL;
+    }
+    free(sc->mark);
+    free(sc->queue);
+    sc->mark = mark;
+    sc->queue = queue;
+    sc->capacity = n;
+    sc->epoch = 0;
+  }
+
+  sc->epoch++;
+  if (sc->epoch == 0) {
+    memset(sc->mark, 0, sizeof(unsigned int) * sc->capacity);
+    sc->epoch = 1;
+  }
+
+  return sc;
+}
+
+/*----------------------------------------------------------------------------------------*/
+SnapshotStore *snapshot_storeNew(const Radio *r, int max_readers) {
+  SnapshotStore *s;
+  Snapshot *v, *d = NULL;
+  Music *m;
+  int *offsets = NULL, *targets = NULL;
+  int i, k, n = 0;
+  Status st = OK;
+
+  if (max_readers <= 0) return NULL;
+
+  s = (SnapshotStore *)calloc(1, sizeof(SnapshotStore));
+  if (!s) return NULL;
+
+  s->hazards = (_Atomic(Snapshot *) *)malloc(sizeof(_Atomic(Snapshot *)) * max_readers);
+  v = snapshot_versionNew(-1, INIT_BLOCKS);
+  if (!s->hazards || !v) {
+    free(s->hazards);
+    free(s);
+    snapshot_versionFree(v);
+    return NULL;
+  }
+
+  s->max_readers = max_readers;
+  for (i = 0; i < max_readers; i++) atomic_init(&s->hazards[i], NULL);
+  atomic_init(&s->current, v);
+
+  /* Version 0 is the first draft of an empty version -1 */
+  d = snapshot_draft(s);
+  if (!d) st = ERROR;
+  if (st == OK && r) {
+    /* Music are copied in order, so positions match the relations */
+    st = radio_getAdjacency(r, &n, &offsets, &targets);
+    for (i = 0; st == OK && i < n; i++) {
+      m = (Music *)music_copy(radio_getMusicAt(r, i));
+      st = snapshot_appendMusic(d, m);
+      if (st == ERROR) music_free(m);
+    }
+
+    for (i = 0; st == OK && i < n; i++) {
+      for (k = offsets[i]; st == OK && k < offsets[i + 1]; k++) {
+        st = snapshot_insertRelation(d, i, targets[k]);
+      }
+    }
+    free(offsets);
+    free(targets);
+  }
+
+  if (st == OK) st = snapshot_commit(s);
+  if (st == ERROR) {
+    snapshot_storeFree(s);
+    return NULL;
+  }
+
+  return s;
+}
+
+void snapshot_storeFree(SnapshotStore *s) {
+  Snapshot *newest, *v;
+  int i;
+
+  if (!s) return;
+
+  /* Music are never removed, so the newest version has all of them */
+  newest = s->draft ? s->draft : atomic_load(&s->current);
+  for (i = 0; i < newest->num_music; i++) {
+    music_free(newest->blocks[i / SNAPSHOT_BLOCK]->songs[i % SNAPSHOT_BLOCK]);
+  }
+
+  while (s->retired) {
+    v = s->retired;
+    s->retired = v->next;
+    snapshot_versionFree(v);
+  }
+  snapshot_versionFree(s->draft);
+  snapshot_versionFree(atomic_load(&s->current));
+  free(s->hazards);
+  free(s);
+}
+
+const Snapshot *snapshot_acquire(SnapshotStore *s, int reader) {
+  Snapshot *v;
+
+  if (!s || reader < 0 || reader >= s->max_readers) return NULL;
+
+  /* The version cannot be freed once it is announced and still current */
+  do {
+    v = atomic_load(&s->current);
+    atomic_store(&s->hazards[reader], v);
+  } while (v != atomic_load(&s->current));
+
+  return v;
+}
+
+void snapshot_release(SnapshotStore *s, int reader) {
+  if (!s || reader < 0 || reader >= s->max_readers) return;
+
+  atomic_store(&s->hazards[reader], NULL);
+}
+
+Status snapshot_newMusic(SnapshotStore *s, char *desc) {
+  Snapshot *d;
+  Music *m;
+
+  if (!s || !desc) return ERROR;
+
+  m = music_initFromString(desc);
+  if (!m) return ERROR;
+
+  d = snapshot_draft(s);
+  if (!d || snapshot_getIndexById(d, music_getId(m)) >= 0) {
+    music_free(m);
+    return d ? OK : ERROR;
+  }
+
+  if (snapshot_appendMusic(d, m) == ERROR) {
+    music_free(m);
+    return ERROR;
+  }
+
+  return OK;
+}
+
+Status snapshot_newRelation(SnapshotStore *s, long orig, long dest) {
+  Snapshot *d;
+  int i_orig, i_dest;
+
+  if (!s) return ERROR;
+
+  d = snapshot_draft(s);
+  if (!d) return ERROR;
+
+  i_orig = snapshot_getIndexById(d, orig);
+  i_dest = snapshot_getIndexById(d, dest);
+  if (i_orig < 0 || i_dest < 0) return ERROR;
+
+  return snapshot_insertRelation(d, i_orig, i_dest);
+}
+
+Status snapshot_commit(SnapshotStore *s) {
+  Snapshot *old;
+
+  if (!s) return ERROR;
+  if (!s->draft) return OK;
+
+  old = atomic_load(&s->current);
+  atomic_store(&s->current, s->draft);
+  s->draft = NULL;
+
+  old->next = s->retired;
+  s->retired = old;
+  snapshot_reclaim(s);
+
+  return OK;
+}
+
+int snapshot_reclaim(SnapshotStore *s) {
+  Snapshot **prev, *v;
+  int pending = 0;
+
+  if (!s) return -1;
+
+  prev = &s->retired;
+  while (*prev) {
+    v = *prev;
+    if (snapshot_isHeld(s, v) == TRUE) {
+      prev = &v->next;
+      pending++;
+    } else {
+      *prev = v->next;
+      snapshot_versionFree(v);
+    }
+  }
+
+  return pending;
+}
+
+long snapshot_getNumber(const Snapshot *v) {
+  if (!v) return -1;
+
+  return v->number;
+}
+
+int snapshot_getNumberOfMusic(const Snapshot *v) {
+  if (!v) return -1;
+
+  return v->num_music;
+}
+
+int snapshot_getNumberOfRelations(const Snapshot *v) {
+  if (!v) return -1;
+
+  return v->num_relations;
+}
+
+const Music *snapshot_getMusicAt(const Snapshot *v, int index) {
+  if (!v || index < 0 || index >= v->num_music) return NULL;
+
+  return v->blocks[index / SNAPSHOT_BLOCK]->songs[index % SNAPSHOT_BLOCK];
+}
+
+const int *snapshot_getRelationsAt(const Snapshot *v, int index, int *n) {
+  const SnapshotList *l;
+
+  if (n) *n = 0;
+  if (!v || !n || index < 0 || index >= v->num_music) return NULL;
+
+  l = v->blocks[index / SNAPSHOT_BLOCK]->lists[index % SNAPSHOT_BLOCK];
+  if (!l) return NULL;
+
+  *n = l->size;
+
+  return l->dest;
+}
+
+int snapshot_getIndexById(const Snapshot *v, long id) {
+  const SnapshotIds *ids;
+  int k;
+
+  if (!v) return -1;
+
+  ids = v->ids[snapshot_hashId(id)];
+  k = snapshot_idsFind(ids, id);
+  if (!ids || k == ids->size || ids->entry[k].id != id) return -1;
+
+  return ids->entry[k].index;
+}
+
+int snapshot_distance(const Snapshot *v, long from_id, long to_id) {
+  SnapshotScratch *sc;
+  const int *list;
+  int i_from, i_to, head = 0, tail = 0, level_end, dist = 0, u, k, n;
+
+  i_from = snapshot_getIndexById(v, from_id);
+  i_to = snapshot_getIndexById(v, to_id);
+  if (i_from < 0 || i_to < 0) return -1;
+  if (i_from == i_to) return 0;
+
+  sc = snapshot_getScratch(v->num_music);
+  if (!sc) return -1;
+
+  /* The queue holds one level after another; level_end closes the current one */
+  sc->mark[i_from] = sc->epoch;
+  sc->queue[tail++] = i_from;
+  level_end = tail;
+
+  while (head < tail) {
+    u = sc->queue[head++];
+
+    list = snapshot_getRelationsAt(v, u, &n);
+    for (k = 0; k < n; k++) {
+      if (list[k] == i_to) return dist + 1;
+      if (sc->mark[list[k]] != sc->epoch) {
+        sc->mark[list[k]] = sc->epoch;
+        sc->queue[tail++] = list[k];
+      }
+    }
+
+    if (head == level_end) {
+      dist++;
+      level_end = tail;
+    }
+  }
+
+  return -1;
+}
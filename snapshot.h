@@ -0,0 +1,211 @@
+/**
+ * @file snapshot.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Copy-on-write snapshots of a radio for concurrent readers
+ *
+ * @details A SnapshotStore keeps the current version of a radio. Readers
+ * acquire it without locks and can keep using it, unchanged, while one
+ * writer adds music and relations to a draft of the next version. The
+ * music and the adjacency lists are stored in blocks of SNAPSHOT_BLOCK
+ * music; the draft shares every block it does not modify with the
+ * previous version and copies the others. Publishing the draft replaces
+ * the current version; the old one is freed once no reader holds it.
+ *
+ * Readers announce the version they hold in a hazard slot of their own,
+ * numbered from 0 to max_readers - 1, so a slot must not be used by two
+ * threads at the same time. Only one thread can call the writer functions
+ * (snapshot_newMusic, snapshot_newRelation, snapshot_commit and
+ * snapshot_reclaim).
+ *
+ * Every version also has an index from ids to positions, split in buckets
+ * that are shared between versions like the blocks, so looking up an id
+ * does not scan the music.
+ *
+ * Songs are identified by their position, from 0 to the number of music
+ * minus one, which never changes from one version to the next.
+ *
+ * @see radio.h
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "music.h"
+#include "radio.h"
+#include "types.h"
+
+/**
+ * @brief Number of music per block shared between versions.
+ */
+#define SNAPSHOT_BLOCK 64
+
+typedef struct _Snapshot Snapshot;
+
+typedef struct _SnapshotStore SnapshotStore;
+
+/**
+ * @brief Creates a store whose first version is a copy of a radio.
+ *
+ * @param r Pointer to the radio (NULL for an empty store).
+ * @param max_readers Number of reader slots.
+ *
+ * @return A pointer to the store, or NULL if there is any error.
+ */
+SnapshotStore *snapshot_storeNew(const Radio *r, int max_readers);
+
+/**
+ * @brief Frees a store and all its versions.
+ *
+ * No reader can hold a version when the store is freed.
+ *
+ * @param s Pointer to the store.
+ */
+void snapshot_storeFree(SnapshotStore *s);
+
+/**
+ * @brief Gets the current version of a store.
+ *
+ * Never blocks: the version is announced in the hazard slot of the reader
+ * and stays valid until snapshot_release is called with the same slot.
+ *
+ * @param s Pointer to the store.
+ * @param reader Hazard slot of the reader, in [0, max_readers).
+ *
+ * @return The current version, or NULL if there is any error.
+ */
+const Snapshot *snapshot_acquire(SnapshotStore *s, int reader);
+
+/**
+ * @brief Releases the version held by a reader.
+ *
+ * @param s Pointer to the store.
+ * @param reader Hazard slot of the reader.
+ */
+void snapshot_release(SnapshotStore *s, int reader);
+
+/**
+ * @brief Adds a music to the draft of the next version.
+ *
+ * @param s Pointer to the store.
+ * @param desc Description of the music (see music_initFromString).
+ *
+ * @return OK if the music was added (or its id already existed), ERROR
+ * otherwise.
+ */
+Status snapshot_newMusic(SnapshotStore *s, char *desc);
+
+/**
+ * @brief Adds a relation to the draft of the next version.
+ *
+ * @param s Pointer to the store.
+ * @param orig Id of the origin music.
+ * @param dest Id of the destination music.
+ *
+ * @return OK if the relation was added (or already existed), ERROR
+ * otherwise.
+ */
+Status snapshot_newRelation(SnapshotStore *s, long orig, long dest);
+
+/**
+ * @brief Publishes the draft as the current version.
+ *
+ * Also frees the old versions that no reader holds any more.
+ *
+ * @param s Pointer to the store.
+ *
+ * @return OK or ERROR.
+ */
+Status snapshot_commit(SnapshotStore *s);
+
+/**
+ * @brief Frees the old versions that no reader holds.
+ *
+ * This is a writer function: it walks the list of old versions, which
+ * only the writer modifies, so it must be called from the writer thread
+ * (or when no thread writes), never from a reader.
+ *
+ * @param s Pointer to the store.
+ *
+ * @return The number of old versions still held by some reader, or -1 if
+ * there is any error.
+ */
+int snapshot_reclaim(SnapshotStore *s);
+
+/**
+ * @brief Gets the number of a version (0 for the first one).
+ *
+ * @param v Pointer to the version.
+ *
+ * @return The number of the version, or -1 if there is any error.
+ */
+long snapshot_getNumber(const Snapshot *v);
+
+/**
+ * @brief Gets the number of music of a version.
+ *
+ * @param v Pointer to the version.
+ *
+ * @return The number of music, or -1 if there is any error.
+ */
+int snapshot_getNumberOfMusic(const Snapshot *v);
+
+/**
+ * @brief Gets the number of relations of a version.
+ *
+ * @param v Pointer to the version.
+ *
+ * @return The number of relations, or -1 if there is any error.
+ */
+int snapshot_getNumberOfRelations(const Snapshot *v);
+
+/**
+ * @brief Gets the music at a given position of a version.
+ *
+ * @param v Pointer to the version.
+ * @param index Position of the music.
+ *
+ * @return The music, or NULL if there is any error.
+ */
+const Music *snapshot_getMusicAt(const Snapshot *v, int index);
+
+/**
+ * @brief Gets the relations leaving the music at a given position.
+ *
+ * @param v Pointer to the version.
+ * @param index Position of the music.
+ * @param n Output, number of relations.
+ *
+ * @return The positions of the destinations in increasing order (NULL if
+ * there are none or there is any error).
+ */
+const int *snapshot_getRelationsAt(const Snapshot *v, int index, int *n);
+
+/**
+ * @brief Gets the position of a music from its id.
+ *
+ * @param v Pointer to the version.
+ * @param id Id of the music.
+ *
+ * @return The position of the music, or -1 if it is not in the version.
+ */
+int snapshot_getIndexById(const Snapshot *v, long id);
+
+/**
+ * @brief Computes the number of relations of the shortest path between
+ * two music.
+ *
+ * Uses its own workspace, so any number of readers can search the same
+ * version at the same time.
+ *
+ * @param v Pointer to the version.
+ * @param from_id Id of the origin music.
+ * @param to_id Id of the destination music.
+ *
+ * @return The number of relations, or -1 if there is no path or there is
+ * any error.
+ */
+int snapshot_distance(const Snapshot *v, long from_id, long to_id);
+
+#endif /* SNAPSHOT_H */
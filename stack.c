@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "alloc.h"
 #include "stack.h"
 
 #define INIT_CAPACITY 2
@@ -28,7 +29,7 @@ static Status stack_incrCapacity(Stack *s) {
   if (!s) return ERROR;
 
   new_capacity = s->capacity * FCT_CAPACITY;
-  tmp = (void **)realloc(s->item, sizeof(void *) * new_capacity);
+  tmp = (void **)alloc_realloc(ALLOC_STACK, s->item, sizeof(void *) * new_capacity);
   if (!tmp) return ERROR;
 
   s->item = tmp;
@@ -40,12 +41,12 @@ static Status stack_incrCapacity(Stack *s) {
 Stack *stack_init() {
   Stack *s;
 
-  s = (Stack *)malloc(sizeof(Stack));
+  s = (Stack *)alloc_malloc(ALLOC_STACK, sizeof(Stack));
   if (!s) return NULL;
 
-  s->item = (void **)malloc(sizeof(void *) * INIT_CAPACITY);
+  s->item = (void **)alloc_malloc(ALLOC_STACK, sizeof(void *) * INIT_CAPACITY);
   if (!s->item) {
-    free(s);
+    alloc_free(s);
     return NULL;
   }
 
@@ -58,8 +59,8 @@ Stack *stack_init() {
 void stack_free(Stack *s) {
   if (!s) return;
 
-  free(s->item);
-  free(s);
+  alloc_free(s->item);
+  alloc_free(s);
 }
 
 Status stack_push(Stack *s, const void *ele) {
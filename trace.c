@@ -0,0 +1,178 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+typedef struct _TraceEvent {
+  const char *name;
+  unsigned long long ns;   /* CLOCK_MONOTONIC time */
+  int tid;                 /* Thread that recorded it */
+  char phase;              /* 'B' begin or 'E' end */
+} TraceEvent;
+
+/* Ring of one thread; events[count % TRACE_EVENTS] is written next */
+typedef struct _TraceBuffer {
+  TraceEvent events[TRACE_EVENTS];
+  unsigned long count;          /* Events recorded, including the overwritten ones */
+  int tid;                      /* Number of the owner thread, in order of first event */
+  struct _TraceBuffer *next;
+  struct _TraceBuffer *next_unused;
+} TraceBuffer;
+
+static const char *trace_path = NULL;
+static TraceBuffer *trace_buffers = NULL;   /* Buffers of all the threads, never freed
+                                               before the dump, since threads may end first */
+static TraceBuffer *trace_unused = NULL;    /* Buffers of ended threads, ready for new ones */
+static int trace_threads = 0;
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static void trace_init(void);
+static void trace_atExit(void);
+static void trace_releaseBuffer(void *arg);
+static TraceBuffer *trace_getBuffer(void);
+static void trace_record(const char *name, char phase);
+
+static void trace_init(void) {
+  const char *env = getenv("RADIO_TRACE");
+
+  if (!env || env[0] == '\0') return;
+  if (pthread_key_create(&trace_key, trace_releaseBuffer) != 0) return;
+
+  trace_path = env;
+  atexit(trace_atExit);
+}
+
+static void trace_atExit(void) {
+  TraceBuffer *b, *next;
+  FILE *pf;
+
+  pf = fopen(trace_path, "w");
+  if (!pf || trace_dump(pf) == ERROR) {
+    fprintf(stderr, "Error: could not write the trace to %s\n", trace_path);
+  }
+  if (pf) fclose(pf);
+
+  pthread_mutex_lock(&trace_mutex);
+  for (b = trace_buffers; b; b = next) {
+    next = b->next;
+    free(b);
+  }
+  trace_buffers = NULL;
+  trace_unused = NULL;
+  pthread_mutex_unlock(&trace_mutex);
+}
+
+/*
+ * Called when a thread ends. Its events stay in the buffer for the dump,
+ * and the next thread keeps recording after them, so a server that starts
+ * a thread per client holds as many buffers as threads run at once.
+ */
+static void trace_releaseBuffer(void *arg) {
+  TraceBuffer *b = (TraceBuffer *)arg;
+
+  pthread_mutex_lock(&trace_mutex);
+  b->next_unused = trace_unused;
+  trace_unused = b;
+  pthread_mutex_unlock(&trace_mutex);
+}
+
+/* The lock is only taken by the first event of every thread */
+static TraceBuffer *trace_getBuffer(void) {
+  TraceBuffer *b;
+
+  b = (TraceBuffer *)pthread_getspecific(trace_key);
+  if (b) return b;
+
+  pthread_mutex_lock(&trace_mutex);
+  b = trace_unused;
+  if (b) {
+    trace_unused = b->next_unused;
+  } else {
+    b = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+    if (b) {
+      b->count = 0;
+      b->next = trace_buffers;
+      trace_buffers = b;
+    }
+  }
+  if (b) b->tid = ++trace_threads;
+  pthread_mutex_unlock(&trace_mutex);
+  if (!b) return NULL;
+
+  pthread_setspecific(trace_key, b);
+
+  return b;
+}
+
+static void trace_record(const char *name, char phase) {
+  struct timespec now;
+  TraceBuffer *b;
+  TraceEvent *e;
+
+  pthread_once(&trace_once, trace_init);
+  if (!trace_path) return;
+
+  b = trace_getBuffer();
+  if (!b) return;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  e = &b->events[b->count % TRACE_EVENTS];
+  e->name = name;
+  e->ns = (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+  e->tid = b->tid;
+  e->phase = phase;
+  /* Publishes the event to trace_dump after it is complete */
+  __atomic_store_n(&b->count, b->count + 1, __ATOMIC_RELEASE);
+}
+
+/*----------------------------------------------------------------------------------------*/
+void trace_begin(const char *name) {
+  trace_record(name, 'B');
+}
+
+void trace_end(const char *name) {
+  trace_record(name, 'E');
+}
+
+Status trace_dump(FILE *pf) {
+  TraceBuffer *b;
+  TraceEvent *e;
+  unsigned long count, first, i;
+  int sep = 0;
+
+  pthread_once(&trace_once, trace_init);
+  if (!pf || !trace_path) return ERROR;
+
+  if (fprintf(pf, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [") < 0) return ERROR;
+
+  pthread_mutex_lock(&trace_mutex);
+  for (b = trace_buffers; b; b = b->next) {
+    count = __atomic_load_n(&b->count, __ATOMIC_ACQUIRE);
+    first = (count > TRACE_EVENTS) ? count - TRACE_EVENTS : 0;
+    for (i = first; i < count; i++) {
+      e = &b->events[i % TRACE_EVENTS];
+      /* Chrome wants microseconds; the decimals keep the nanoseconds */
+      if (fprintf(pf, "%s\n{\"name\": \"%s\", \"ph\": \"%c\", \"ts\": %llu.%03llu, "
+                  "\"pid\": %ld, \"tid\": %d}",
+                  sep ? "," : "", e->name, e->phase, e->ns / 1000, e->ns % 1000,
+                  (long)getpid(), e->tid) < 0) {
+        break;
+      }
+      sep = 1;
+    }
+    if (i < count) break;
+  }
+  pthread_mutex_unlock(&trace_mutex);
+
+  if (b || fprintf(pf, "\n]}\n") < 0) return ERROR;
+
+  return OK;
+}
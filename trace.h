@@ -0,0 +1,58 @@
+/**
+ * @file trace.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Timeline of the library operations of every thread
+ *
+ * @details When the environment variable RADIO_TRACE names a file, every
+ * thread records timestamped begin and end events in a ring buffer of its
+ * own, of TRACE_EVENTS events; when it is full the oldest events are
+ * overwritten. Recording takes no lock: a thread only writes its own
+ * buffer and publishes the number of events with an atomic store. When a
+ * thread ends its buffer goes to the next thread that records, after the
+ * events already there, so the memory grows with the threads that run at
+ * once, not with all the threads ever started. At exit
+ * all the buffers are written to the file in the Chrome trace event
+ * format, which chrome://tracing and Perfetto open.
+ *
+ * Event names must be string literals (only the pointer is kept). Without
+ * RADIO_TRACE every event costs one check.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+#include "types.h"
+
+#define TRACE_EVENTS 65536
+
+/**
+ * @brief Records the start of an operation in the calling thread.
+ *
+ * @param name Name of the operation.
+ */
+void trace_begin(const char *name);
+
+/**
+ * @brief Records the end of an operation in the calling thread.
+ *
+ * @param name Name of the operation, the same given to trace_begin.
+ */
+void trace_end(const char *name);
+
+/**
+ * @brief Writes the events recorded so far in Chrome trace format.
+ *
+ * Events still being recorded by other threads may be missing or, if
+ * their buffer wraps around meanwhile, replaced by newer ones.
+ *
+ * @param pf File descriptor.
+ *
+ * @return OK, or ERROR if there is any error or RADIO_TRACE is not set.
+ */
+Status trace_dump(FILE *pf);
+
+#endif /* TRACE_H */
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "walk.h"
+
+/* Samples tried before scanning the neighbours for a song not recently played */
+#define WALK_RETRIES 8
+
+struct _Walk {
+  Music **songs;            /* Songs of the radio, by position */
+  int n;                    /* Number of songs */
+  int *offsets;             /* CSR offsets of the relations */
+  int *targets;             /* Destinations of the relations */
+  double *prob;             /* Alias table probabilities, one per relation */
+  int *alias;               /* Alias table alternatives, one per relation */
+  long *last_step;          /* Step at which every song was last played */
+  long step;                /* Number of songs returned so far */
+  int window;               /* Number of recent songs to avoid */
+  int current;              /* Position of the current song */
+  unsigned long long rng;   /* xorshift64* state */
+};
+
+/*----------------------------------------------------------------------------------------*/
+/*
+Private functions:
+*/
+static unsigned long long walk_rand(Walk *w);
+static int walk_randInt(Walk *w, int n);
+static double walk_randDouble(Walk *w);
+static Bool walk_isRecent(const Walk *w, int slot);
+static Status walk_buildAlias(Walk *w, const double *weights, p_walk_weight weight);
+static int walk_restart(Walk *w);
+static int walk_step(Walk *w);
+
+static unsigned long long walk_rand(Walk *w) {
+  w->rng ^= w->rng >> 12;
+  w->rng ^= w->rng << 25;
+  w->rng ^= w->rng >> 27;
+
+  return w->rng * 2685821657736338717ULL;
+}
+
+/* Uniform integer in [0, n) by multiply-shift, without divisions */
+static int walk_randInt(Walk *w, int n) {
+  return (int)(((walk_rand(w) >> 32) * (unsigned long long)n) >> 32);
+}
+
+static double walk_randDouble(Walk *w) {
+  return (walk_rand(w) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static Bool walk_isRecent(const Walk *w, int slot) {
+  if (w->window <= 0 || w->last_step[slot] < 0) return FALSE;
+
+  return (w->step - w->last_step[slot] <= w->window) ? TRUE : FALSE;
+}
+
+/* Vose's alias method, applied to the relations of every song; weight overrides weights */
+static Status walk_buildAlias(Walk *w, const double *weights, p_walk_weight weight) {
+  double *scaled;
+  int *small, *large;
+  int i, k, d, max_d = 1, n_small, n_large, s, l;
+  double total;
+
+  for (i = 0; i < w->n; i++) {
+    d = w->offsets[i + 1] - w->offsets[i];
+    if (d > max_d) max_d = d;
+  }
+
+  scaled = (double *)malloc(sizeof(double) * max_d);
+  small = (int *)malloc(sizeof(int) * max_d);
+  large = (int *)malloc(sizeof(int) * max_d);
+  if (!scaled || !small || !large) {
+    free(scaled);
+    free(small);
+    free(large);
+    return ERROR;
+  }
+
+  for (i = 0; i < w->n; i++) {
+    d = w->offsets[i + 1] - w->offsets[i];
+    if (d == 0) continue;
+
+    total = 0.0;
+    for (k = 0; k < d; k++) {
+      scaled[k] = weight ? weight(w->songs[i], w->songs[w->targets[w->offsets[i] + k]])
+                         : weights[w->offsets[i] + k];
+      if (scaled[k] < 0.0) scaled[k] = 0.0;
+      total += scaled[k];
+    }
+
+    n_small = n_large = 0;
+    for (k = 0; k < d; k++) {
+      scaled[k] = (total > 0.0) ? scaled[k] * d / total : 1.0;
+      if (scaled[k] < 1.0) {
+        small[n_small++] = k;
+      } else {
+        large[n_large++] = k;
+      }
+    }
+
+    while (n_small > 0 && n_large > 0) {
+      s = small[--n_small];
+      l = large[--n_large];
+      w->prob[w->offsets[i] + s] = scaled[s];
+      w->alias[w->offsets[i] + s] = l;
+      scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+      if (scaled[l] < 1.0) {
+        small[n_small++] = l;
+      } else {
+        large[n_large++] = l;
+      }
+    }
+    /* Leftovers are 1 up to rounding errors */
+    while (n_large > 0) {
+      l = large[--n_large];
+      w->prob[w->offsets[i] + l] = 1.0;
+      w->alias[w->offsets[i] + l] = l;
+    }
+    while (n_small > 0) {
+      s = small[--n_small];
+      w->prob[w->offsets[i] + s] = 1.0;
+      w->alias[w->offsets[i] + s] = s;
+    }
+  }
+
+  free(scaled);
+  free(small);
+  free(large);
+
+  return OK;
+}
+
+/* Jumps to a random song, avoiding the recent ones when possible */
+static int walk_restart(Walk *w) {
+  int i, slot = 0;
+
+  for (i = 0; i < WALK_RETRIES; i++) {
+    slot = walk_randInt(w, w->n);
+    if (walk_isRecent(w, slot) == FALSE) break;
+  }
+
+  return slot;
+}
+
+static int walk_step(Walk *w) {
+  int base, d, i, k, slot = -1;
+
+  base = w->offsets[w->current];
+  d = w->offsets[w->current + 1] - base;
+  if (d == 0) return walk_restart(w);
+
+  for (i = 0; i < WALK_RETRIES; i++) {
+    k = walk_randInt(w, d);
+    if (walk_randDouble(w) >= w->prob[base + k]) k = w->alias[base + k];
+
+    slot = w->targets[base + k];
+    if (walk_isRecent(w, slot) == FALSE) return slot;
+  }
+
+  /* Every sample was recent: take the first related song that is not */
+  k = walk_randInt(w, d);
+  for (i = 0; i < d; i++) {
+    if (walk_isRecent(w, w->targets[base + (k + i) % d]) == FALSE) {
+      return w->targets[base + (k + i) % d];
+    }
+  }
+
+  return slot;
+}
+
+/*----------------------------------------------------------------------------------------*/
+Walk *walk_new(const Radio *r, long seed_id, unsigned long rng_seed, int window,
+               p_walk_weight weight) {
+  Walk *w;
+  double *weights = NULL;
+  int i, m;
+  Status st;
+
+  if (!r || window < 0) return NULL;
+
+  w = (Walk *)calloc(1, sizeof(Walk));
+  if (!w) return NULL;
+
+  /* The relation weights are only needed when no function replaces them */
+  if (radio_getWeightedAdjacency(r, &w->n, &w->offsets, &w->targets,
+                                 weight ? NULL : &weights) == ERROR) {
+    free(w);
+    return NULL;
+  }
+  m = w->offsets[w->n];
+  w->current = _radio_findmusicById(r, seed_id);
+  if (w->n <= 0 || w->current < 0 || w->current >= w->n) {
+    free(w->offsets);
+    free(w->targets);
+    free(weights);
+    free(w);
+    return NULL;
+  }
+
+  w->songs = (Music **)malloc(sizeof(Music *) * w->n);
+  w->last_step = (long *)malloc(sizeof(long) * w->n);
+  w->prob = (double *)malloc(sizeof(double) * (m > 0 ? m : 1));
+  w->alias = (int *)malloc(sizeof(int) * (m > 0 ? m : 1));
+  if (!w->songs || !w->last_step || !w->prob || !w->alias) {
+    free(weights);
+    walk_free(w);
+    return NULL;
+  }
+
+  for (i = 0; i < w->n; i++) {
+    w->songs[i] = radio_getMusicAt(r, i);
+    w->last_step[i] = -1;
+  }
+
+  st = walk_buildAlias(w, weights, weight);
+  free(weights);
+  if (st == ERROR) {
+    walk_free(w);
+    return NULL;
+  }
+
+  /* xorshift must not start at 0 */
+  w->rng = (unsigned long long)rng_seed ^ 0x9E3779B97F4A7C15ULL;
+  if (w->rng == 0) w->rng = 0x9E3779B97F4A7C15ULL;
+  w->window = window;
+  w->step = 0;
+
+  return w;
+}
+
+void walk_free(Walk *w) {
+  if (!w) return;
+
+  free(w->songs);
+  free(w->offsets);
+  free(w->targets);
+  free(w->prob);
+  free(w->alias);
+  free(w->last_step);
+  free(w);
+}
+
+Music *walk_next(Walk *w) {
+  if (!w) return NULL;
+
+  if (w->step > 0) w->current = walk_step(w);
+
+  w->last_step[w->current] = w->step;
+  w->step++;
+
+  return w->songs[w->current];
+}
+
+Status walk_fill(Walk *w, Queue *q, size_t n) {
+  Music *m;
+
+  if (!w || !q) return ERROR;
+
+  while (queue_size(q) < n) {
+    m = walk_next(w);
+    if (!m || queue_push(q, m) == ERROR) return ERROR;
+  }
+
+  return OK;
+}
+
+double walk_uniformWeight(const Music *from, const Music *to) {
+  (void)from;
+  (void)to;
+
+  return 1.0;
+}
+
+double walk_durationWeight(const Music *from, const Music *to) {
+  /* Only the destination matters: every song of a list has the same origin */
+  (void)from;
+  if (!to) return 0.0;
+
+  return (double)music_getDuration(to);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file walk.h
+ * @author Profesores EDAT
+ * @date February 2026
+ * @version 1.0
+ * @brief Random-walk song generator ("radio mode") over a radio
+ *
+ * @details A Walk starts at a seed song and, at every step, moves to one of
+ * the songs related to the current one, with a probability proportional to
+ * the weight of the relation (see radio_newWeightedRelation), or to the
+ * weight given by a function. The destinations are sampled with an alias
+ * table per song, so every step costs O(1) and does not allocate
+ * memory. Songs played in the last window steps are avoided when possible,
+ * and a song without relations restarts the walk at a random song.
+ *
+ * The walk works over a copy of the relations taken by walk_new: later
+ * changes to the radio are not seen by the walk, but the radio must
+ * outlive it because the returned Music belong to the radio.
+ *
+ * @see radio.h
+ */
+
+#ifndef WALK_H
+#define WALK_H
+
+#include "music.h"
+#include "queue.h"
+#include "radio.h"
+#include "types.h"
+
+typedef struct _Walk Walk;
+
+/**
+ * @brief Typedef for the weight of moving from one music to another, to
+ * be used instead of the weights of the relations.
+ *
+ * The weight must be greater or equal than 0. A song whose relations all
+ * have weight 0 picks among them uniformly.
+ */
+typedef double (*p_walk_weight)(const Music *from, const Music *to);
+
+/**
+ * @brief Creates a random walk over a radio.
+ *
+ * @param r Pointer to the radio.
+ * @param seed_id ID of the music where the walk starts.
+ * @param rng_seed Seed of the random generator; the same seed always
+ * produces the same sequence of songs.
+ * @param window Number of recently played songs to avoid (0 allows
+ * immediate repetitions).
+ * @param weight Function giving the weight of every relation, or NULL to
+ * use the weights stored in the relations (relations created without a
+ * weight have RADIO_DEFAULT_WEIGHT, so an unweighted radio is uniform).
+ *
+ * @return A pointer to the walk, or NULL if there is any error.
+ */
+Walk *walk_new(const Radio *r, long seed_id, unsigned long rng_seed, int window,
+               p_walk_weight weight);
+
+/**
+ * @brief Frees a random walk.
+ *
+ * @param w Pointer to the walk.
+ */
+void walk_free(Walk *w);
+
+/**
+ * @brief Advances the walk one step.
+ *
+ * The first call returns the seed song.
+ *
+ * @param w Pointer to the walk.
+ *
+ * @return The next Music of the walk, or NULL if there is any error.
+ */
+Music *walk_next(Walk *w);
+
+/**
+ * @brief Pushes songs of the walk into a queue until it has n elements.
+ *
+ * @param w Pointer to the walk.
+ * @param q Pointer to the queue.
+ * @param n Number of songs the queue must hold.
+ *
+ * @return OK or ERROR.
+ */
+Status walk_fill(Walk *w, Queue *q, size_t n);
+
+/**
+ * @brief Weight function that picks the related songs uniformly, ignoring
+ * the weights of the relations.
+ *
+ * @param from Origin music.
+ * @param to Destination music.
+ *
+ * @return 1.
+ */
+double walk_uniformWeight(const Music *from, const Music *to);
+
+/**
+ * @brief Weight function that favours longer destination songs.
+ *
+ * @param from Origin music.
+ * @param to Destination music.
+ *
+ * @return The duration of the destination music.
+ */
+double walk_durationWeight(const Music *from, const Music *to);
+
+#endif /* WALK_H */